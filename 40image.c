@@ -7,7 +7,8 @@
  *     Produces errors if commands are not valid (are not compression or 
  *     decompression) or if the file provided by the client is invalid. Relies 
  *     on compress40 interface to run either the compression or decompression
- *     program, depending on the command. 
+ *     program, depending on the command. With '-b', it instead compresses or
+ *     decompresses a whole batch of files on a pool of worker threads.
  */
 
 #include <string.h>
@@ -15,8 +16,40 @@
 #include <stdio.h>
 #include "assert.h"
 #include "compress40.h"
+#include "parallel.h"
+#include "mem.h"
+#include "stats.h"
+#include "texcept.h"
 
-static void (*compress_or_decompress)(FILE *input) = compress40;
+static void (*codec)(FILE *input, FILE *output) = compress40_to;
+static const char *operation = "compress";
+static unsigned region[4];
+static int use_region = 0;
+static int use_thumbnail = 0;
+
+/* struct Job - One file of a batch, and the file its result goes to */
+struct Job {
+        char *input;
+        char *output;
+};
+
+/* struct Batch - The jobs of a batch, and how many of them failed */
+struct Batch {
+        struct Job *jobs;
+        int count;
+        int failed;
+};
+
+static void decompress_region(FILE *input, FILE *output);
+static char *output_name(const char *input, const char *dir);
+static void add_job(struct Batch *batch, int *capacity, const char *input,
+                    const char *output, const char *dir);
+static void read_manifest(FILE *fp, struct Batch *batch, int *capacity,
+                          const char *dir);
+static const char *run_codec(FILE *input, FILE *output);
+static void run_job(int first, int last, void *cl);
+static int run_batch(int argc, char *argv[], unsigned workers,
+                     const char *dir);
 
 /***************************main**********************************
 *
@@ -27,45 +60,415 @@ static void (*compress_or_decompress)(FILE *input) = compress40;
 *             char *argv[]: the command line arguments given
 *
 * Expects: Expects that the commands are either '-c' or '-d' and that the image
-*          file is a proper file. 
+*          file is a proper file. '-t N' sets the number of threads to use,
+*          where N = 0 means one per online processor. '-i' compresses or 
+*          decompresses with integer (fixed-point) arithmetic instead of 
+*          floating point. '-v' or '--stats' writes the time spent in each 
+*          stage, the number of pixels and blocks, and the peak memory use
+*          to stderr once the image is done. '-b' switches to batch mode:
+*          every file named on the command line is processed, or, if there
+*          are none (or just '-'), every file named in a manifest on stdin, 
+*          one per line. '-j N' sets the number of files to work on at once
+*          (0, the default, means one per online processor), and '-o dir' 
+*          puts the results in dir instead of next to their inputs. 
+*          '-T N' compresses to a tiled image with N by N pixel tiles, '-e'
+*          entropy codes the tiles (256 by 256 pixels unless -T is given), 
+*          '-l' run-length codes an untiled image's repeated blocks (so it 
+*          cannot be given with -T or -e), '-B N' compresses N by N pixel
+*          blocks (2, the default, 4 or 8, which cannot be combined with 
+*          '-i', '-T', '-e' or '-l'), and '-r x,y,w,h' decompresses only the
+*          w by h rectangle whose top left pixel is (x, y). '-s' decompresses
+*          a thumbnail of half the width and height, one pixel per block, 
+*          alone or in a batch.
 *
 * Return: An int containing whether the program ran successfully 
 *
 * Notes: Relies on the compress40 interface to run either the compression or
 *        decompression program. Exits if the commands are invalid and throws
-*        checked runtime error if file cannot be open. 
+*        checked runtime error if file cannot be open. A bad image, or a 
+*        region or thumbnail the image cannot give, is reported on stderr 
+*        with the reason for its exception, and the program exits with 1.
 *********************************************************************/
 int main(int argc, char *argv[])
 {
         int i;
+        int batch = 0;
+        int tiled = 0, coded = 0, run_length = 0, fixed = 0;
+        long block_size = 2;
+        unsigned workers = 0;
+        const char *dir = NULL;
 
         for (i = 1; i < argc; i++) {
                 if (strcmp(argv[i], "-c") == 0) {
-                        compress_or_decompress = compress40;
+                        codec = compress40_to;
+                        operation = "compress";
                 } else if (strcmp(argv[i], "-d") == 0) {
-                        compress_or_decompress = decompress40;
+                        codec = decompress40_to;
+                        operation = "decompress";
+                } else if (strcmp(argv[i], "-t") == 0 && i + 1 < argc) {
+                        char *end;
+                        long threads = strtol(argv[++i], &end, 10);
+                        if (*end != '\0' || threads < 0) {
+                                fprintf(stderr, "%s: bad thread count '%s'\n",
+                                        argv[0], argv[i]);
+                                exit(1);
+                        }
+                        compress40_set_threads(threads == 0 ? 
+                                               Parallel_processors() : 
+                                               (unsigned) threads);
+                } else if (strcmp(argv[i], "-i") == 0) {
+                        compress40_set_fixed_point(1);
+                        fixed = 1;
+                } else if (strcmp(argv[i], "-v") == 0 || 
+                           strcmp(argv[i], "--stats") == 0) {
+                        Stats_enable();
+                } else if (strcmp(argv[i], "-b") == 0) {
+                        batch = 1;
+                } else if (strcmp(argv[i], "-j") == 0 && i + 1 < argc) {
+                        char *end;
+                        long n = strtol(argv[++i], &end, 10);
+                        if (*end != '\0' || n < 0) {
+                                fprintf(stderr, "%s: bad worker count '%s'\n",
+                                        argv[0], argv[i]);
+                                exit(1);
+                        }
+                        workers = n;
+                } else if (strcmp(argv[i], "-o") == 0 && i + 1 < argc) {
+                        dir = argv[++i];
+                } else if (strcmp(argv[i], "-T") == 0 && i + 1 < argc) {
+                        char *end;
+                        long size = strtol(argv[++i], &end, 10);
+                        if (*end != '\0' || size < 0 || size % 2 != 0 ||
+                            size > 1L << 30) {
+                                fprintf(stderr, "%s: bad tile size '%s' "
+                                        "(must be even)\n", argv[0], argv[i]);
+                                exit(1);
+                        }
+                        compress40_set_tile_size(size);
+                        tiled = size != 0;
+                } else if (strcmp(argv[i], "-e") == 0) {
+                        compress40_set_entropy_coding(1);
+                        coded = 1;
+                } else if (strcmp(argv[i], "-l") == 0) {
+                        compress40_set_run_length(1);
+                        run_length = 1;
+                } else if (strcmp(argv[i], "-B") == 0 && i + 1 < argc) {
+                        char *end;
+                        long size = strtol(argv[++i], &end, 10);
+                        if (*end != '\0' || 
+                            (size != 2 && size != 4 && size != 8)) {
+                                fprintf(stderr, "%s: bad block size '%s' "
+                                        "(must be 2, 4 or 8)\n", argv[0], 
+                                        argv[i]);
+                                exit(1);
+                        }
+                        compress40_set_block_size(size);
+                        block_size = size;
+                } else if (strcmp(argv[i], "-s") == 0) {
+                        use_thumbnail = 1;
+                } else if (strcmp(argv[i], "-r") == 0 && i + 1 < argc) {
+                        int length = 0;
+                        if (sscanf(argv[++i], "%u,%u,%u,%u%n", &region[0],
+                                   &region[1], &region[2], &region[3], 
+                                   &length) != 4 || argv[i][length] != '\0') {
+                                fprintf(stderr, "%s: bad region '%s' "
+                                        "(expected x,y,w,h)\n", argv[0], 
+                                        argv[i]);
+                                exit(1);
+                        }
+                        use_region = 1;
+                } else if (batch && strcmp(argv[i], "-") == 0) {
+                        break;
                 } else if (*argv[i] == '-') {
                         fprintf(stderr, "%s: unknown option '%s'\n",
                                 argv[0], argv[i]);
                         exit(1);
-                } else if (argc - i > 2) {
-                        fprintf(stderr, "Usage: %s -d [filename]\n"
-                                "       %s -c [filename]\n",
-                                argv[0], argv[0]);
+                } else if (!batch && argc - i > 2) {
+                        fprintf(stderr, "Usage: %s -d [-i] [-v] [-t threads] "
+                                "[filename]\n"
+                                "       %s -c [-i] [-v] [-t threads] "
+                                "[filename]\n"
+                                "       %s -c|-d -b [-i] [-v] [-t threads] "
+                                "[-j workers] [-o dir] [filename...]\n"
+                                "Compress with -T tile_size for a tiled "
+                                "image and -e to entropy code it, -l "
+                                "to run-length code it, or -B 4|8 for "
+                                "larger blocks; decompress with "
+                                "-r x,y,w,h for a region, or -s for a "
+                                "half-size thumbnail\n",
+                                argv[0], argv[0], argv[0]);
                         exit(1);
                 } else {
                         break;
                 }
         }
+        if (use_region && (batch || codec != decompress40_to)) {
+                fprintf(stderr, "%s: -r only works when decompressing one "
+                        "file\n", argv[0]);
+                exit(1);
+        }
+        if (use_thumbnail && (use_region || 
+                              codec != decompress40_to)) {
+                fprintf(stderr, "%s: -s only works when decompressing, "
+                        "without -r\n", argv[0]);
+                exit(1);
+        }
+        if (run_length && (tiled || coded)) {
+                fprintf(stderr, "%s: -l only works without -T and -e\n",
+                        argv[0]);
+                exit(1);
+        }
+        if (block_size != 2 && (fixed || tiled || coded || run_length)) {
+                fprintf(stderr, "%s: -B %ld has no fixed-point codec, tiles "
+                        "or coding, so it cannot be used with -i, -T, -e or "
+                        "-l\n", argv[0], block_size);
+                exit(1);
+        }
+        if (use_region) {
+                codec = decompress_region;
+        }
+        if (use_thumbnail) {
+                codec = decompress40_thumbnail;
+        }
+        if (batch) {
+                int failed = run_batch(argc - i, argv + i, workers == 0 ? 
+                                       Parallel_processors() : workers, dir);
+                Stats_report(stderr, operation);
+                return failed == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+        }
         assert(argc - i <= 1);    /* at most one file on command line */
-        if (i < argc) {
-                FILE *fp = fopen(argv[i], "r");
-                assert(fp != NULL);
-                compress_or_decompress(fp);
+        FILE *fp = i < argc ? fopen(argv[i], "r") : stdin;
+        assert(fp != NULL);
+        const char *reason = run_codec(fp, stdout);
+        if (fp != stdin) {
                 fclose(fp);
-        } else {
-                compress_or_decompress(stdin);
         }
+        fflush(stdout);
+        if (reason != NULL) {
+                fprintf(stderr, "%s: cannot %s '%s': %s\n", argv[0], 
+                        operation, i < argc ? argv[i] : "-", reason);
+                exit(1);
+        }
+        Stats_report(stderr, operation);
 
         return EXIT_SUCCESS; 
 }
+
+/* Decompresses the rectangle given with -r */
+static void decompress_region(FILE *input, FILE *output)
+{
+        decompress40_region(input, output, region[0], region[1], region[2],
+                            region[3]);
+}
+
+/***************************output_name**********************************
+*
+* Picks the name of the file the result of a batch job goes to
+*
+* Parameters: const char *input: the name of the input file
+*             const char *dir: a directory for the output, or NULL to put it
+*                              next to the input
+*
+* Return: a new string, which the caller must free
+*
+* Notes: compressing replaces a .ppm or .pnm extension with .c40, and 
+*        decompressing replaces .c40 with .ppm; any other name just gets the
+*        new extension added
+*********************************************************************/
+static char *output_name(const char *input, const char *dir)
+{
+        const char *from[2], *to;
+        if (codec == compress40_to) {
+                from[0] = ".ppm";
+                from[1] = ".pnm";
+                to = ".c40";
+        } else {
+                from[0] = from[1] = ".c40";
+                to = ".ppm";
+        }
+        if (dir != NULL) {
+                const char *slash = strrchr(input, '/');
+                input = slash != NULL ? slash + 1 : input;
+        }
+        size_t length = strlen(input);
+        for (int k = 0; k < 2; k++) {
+                size_t n = strlen(from[k]);
+                if (length > n && strcmp(input + length - n, from[k]) == 0) {
+                        length -= n;
+                        break;
+                }
+        }
+
+        size_t dir_length = dir != NULL ? strlen(dir) + 1 : 0;
+        char *name = ALLOC(dir_length + length + strlen(to) + 1);
+        if (dir != NULL) {
+                strcpy(name, dir);
+                strcat(name, "/");
+        } else {
+                name[0] = '\0';
+        }
+        strncat(name, input, length);
+        strcat(name, to);
+        return name;
+}
+
+/* Adds a job to a batch, naming its output with output_name unless output 
+ * is given */
+static void add_job(struct Batch *batch, int *capacity, const char *input,
+                    const char *output, const char *dir)
+{
+        if (batch->count == *capacity) {
+                if (*capacity == 0) {
+                        *capacity = 64;
+                        batch->jobs = ALLOC(*capacity * sizeof(*batch->jobs));
+                } else {
+                        *capacity *= 2;
+                        RESIZE(batch->jobs, *capacity * sizeof(*batch->jobs));
+                }
+        }
+        struct Job *job = &batch->jobs[batch->count++];
+        job->input = ALLOC(strlen(input) + 1);
+        strcpy(job->input, input);
+        if (output != NULL) {
+                job->output = ALLOC(strlen(output) + 1);
+                strcpy(job->output, output);
+        } else {
+                job->output = output_name(input, dir);
+        }
+}
+
+/***************************read_manifest**********************************
+*
+* Adds a job for each line of a manifest to a batch
+*
+* Parameters: FILE *fp: the manifest
+*             struct Batch *batch, int *capacity: the batch, and the number 
+*                                  of jobs it has room for
+*             const char *dir: where outputs go, as for output_name
+*
+* Return: nothing
+*
+* Notes: Each line is the name of an input file, optionally followed by a 
+*        tab and the name of its output file. Empty lines are skipped.
+*********************************************************************/
+static void read_manifest(FILE *fp, struct Batch *batch, int *capacity,
+                          const char *dir)
+{
+        char *line = NULL;
+        size_t size = 0;
+        ssize_t length;
+        while ((length = getline(&line, &size, fp)) != -1) {
+                while (length > 0 && (line[length - 1] == '\n' || 
+                                      line[length - 1] == '\r')) {
+                        line[--length] = '\0';
+                }
+                if (length == 0) {
+                        continue;
+                }
+                char *tab = strchr(line, '\t');
+                if (tab != NULL) {
+                        *tab = '\0';
+                }
+                add_job(batch, capacity, line, tab != NULL ? tab + 1 : NULL,
+                        dir);
+        }
+        free(line);
+}
+
+/* Runs codec from input to output, and returns NULL, or the reason for the
+ * exception it raised if the input is bad */
+static const char *run_codec(FILE *input, FILE *output)
+{
+        const char *volatile reason = NULL;
+        TTRY
+                codec(input, output);
+        TELSE
+                reason = Texcept_frame.exception->reason;
+        TEND_TRY;
+        return reason;
+}
+
+/***************************run_job**********************************
+*
+* Compresses or decompresses the files of jobs [first, last) of a batch. An
+* apply function for Parallel_each, so it may run on its own thread.
+*
+* Notes: A file that cannot be opened, or whose image is bad, is reported on
+*        stderr and counted as a failure, and the batch goes on. The codec 
+*        raises a bad image's exception with TRAISE, which run_codec handles
+*        on this thread; whatever was written to its output is removed. 
+*        Checked runtime errors are still fatal, just like for a single 
+*        file.
+*********************************************************************/
+static void run_job(int first, int last, void *cl)
+{
+        struct Batch *batch = cl;
+        for (int i = first; i < last; i++) {
+                struct Job *job = &batch->jobs[i];
+                FILE *input = fopen(job->input, "rb");
+                FILE *output = input != NULL ? fopen(job->output, "wb") : 
+                                               NULL;
+                const char *reason = NULL;
+                int closed = 0;
+                if (output != NULL) {
+                        reason = run_codec(input, output);
+                        closed = fclose(output) == 0;
+                }
+                if (reason != NULL) {
+                        fprintf(stderr, "40image: cannot %s '%s': %s\n", 
+                                operation, job->input, reason);
+                        remove(job->output);
+                } else if (!closed) {
+                        fprintf(stderr, "40image: cannot %s '%s'\n", 
+                                input == NULL ? "read" : "write", 
+                                input == NULL ? job->input : job->output);
+                }
+                if (reason != NULL || !closed) {
+                        __atomic_fetch_add(&batch->failed, 1, 
+                                           __ATOMIC_RELAXED);
+                }
+                if (input != NULL) {
+                        fclose(input);
+                }
+        }
+}
+
+/***************************run_batch**********************************
+*
+* Compresses or decompresses many files in one process
+*
+* Parameters: int argc, char *argv[]: the names of the input files; if there
+*                                     are none, or just "-", they are read
+*                                     from a manifest on stdin
+*             unsigned workers: the number of files to work on at once
+*             const char *dir: where outputs go, as for output_name
+*
+* Return: the number of files that could not be read, written, compressed 
+*         or decompressed
+*
+* Notes: Relies on Parallel_each to hand the files out to the workers one at
+*        a time, so a few large files do not hold up the small ones. Each 
+*        file is itself compressed with the threads set by '-t'.
+*********************************************************************/
+static int run_batch(int argc, char *argv[], unsigned workers,
+                     const char *dir)
+{
+        struct Batch batch = { NULL, 0, 0 };
+        int capacity = 0;
+        if (argc == 0 || (argc == 1 && strcmp(argv[0], "-") == 0)) {
+                read_manifest(stdin, &batch, &capacity, dir);
+        } else {
+                for (int i = 0; i < argc; i++) {
+                        add_job(&batch, &capacity, argv[i], NULL, dir);
+                }
+        }
+
+        Parallel_each(workers, batch.count, run_job, &batch);
+
+        for (int i = 0; i < batch.count; i++) {
+                FREE(batch.jobs[i].input);
+                FREE(batch.jobs[i].output);
+        }
+        FREE(batch.jobs);
+        return batch.failed;
+}
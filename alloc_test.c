@@ -0,0 +1,140 @@
+/*
+ *     alloc_test.c
+ *     by Abhinav Mummameni (amumma01) and Rolando Ortega (rorteg02)
+ *
+ *     Test program, built and run by 'make test', for the number of heap
+ *     allocations the codec makes. It supplies its own Mem_alloc, Mem_calloc,
+ *     Mem_resize and Mem_free, which count calls and then go to malloc and
+ *     friends, so the linker uses them instead of the CII versions. Each
+ *     image is compressed and decompressed at a small and a large size, and
+ *     the test fails unless both sizes make the same, small number of
+ *     allocations: nothing may be allocated per block or per row.
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include "assert.h"
+#include "mem.h"
+#include "compress40.h"
+#include "testutil.h"
+
+/* No image may need more allocations than this */
+#define MAX_ALLOCATIONS 32
+
+const Except_T Mem_Failed = { "Allocation Failed" };
+
+static long allocations = 0;
+
+void *Mem_alloc(long nbytes, const char *file, int line)
+{
+        assert(nbytes > 0);
+        void *ptr = malloc(nbytes);
+        if (ptr == NULL) {
+                Except_raise(&Mem_Failed, file, line);
+        }
+        __atomic_fetch_add(&allocations, 1, __ATOMIC_RELAXED);
+        return ptr;
+}
+
+void *Mem_calloc(long count, long nbytes, const char *file, int line)
+{
+        assert(count > 0 && nbytes > 0);
+        void *ptr = calloc(count, nbytes);
+        if (ptr == NULL) {
+                Except_raise(&Mem_Failed, file, line);
+        }
+        __atomic_fetch_add(&allocations, 1, __ATOMIC_RELAXED);
+        return ptr;
+}
+
+void *Mem_resize(void *ptr, long nbytes, const char *file, int line)
+{
+        assert(ptr != NULL && nbytes > 0);
+        ptr = realloc(ptr, nbytes);
+        if (ptr == NULL) {
+                Except_raise(&Mem_Failed, file, line);
+        }
+        __atomic_fetch_add(&allocations, 1, __ATOMIC_RELAXED);
+        return ptr;
+}
+
+void Mem_free(void *ptr, const char *file, int line)
+{
+        (void) file;
+        (void) line;
+        free(ptr);
+}
+
+/* Returns the number of allocations it takes to run codec from input to a
+ * new temporary file, which is left in *output, rewound */
+static long count_allocations(void codec(FILE *, FILE *), FILE *input,
+                              FILE **output)
+{
+        *output = tmpfile();
+        assert(*output != NULL);
+        long before = allocations;
+        codec(input, *output);
+        long count = allocations - before;
+        fflush(*output);
+        rewind(*output);
+        return count;
+}
+
+/* Checks that compressing and decompressing a width by height image takes
+ * exactly the allocations *compress and *decompress, or sets them if they
+ * are -1. Returns the number of failures. */
+static int check_size(const char *codec, unsigned width, unsigned height,
+                      long *compress, long *decompress)
+{
+        FILE *image = tmpfile();
+        assert(image != NULL);
+        Testutil_write_image(image, width, height, -1);
+        rewind(image);
+        FILE *compressed, *decompressed;
+        long counts[2];
+        counts[0] = count_allocations(compress40_to, image, &compressed);
+        counts[1] = count_allocations(decompress40_to, compressed,
+                                      &decompressed);
+        fclose(image);
+        fclose(compressed);
+        fclose(decompressed);
+
+        long *expected[2] = { compress, decompress };
+        const char *names[2] = { "compress", "decompress" };
+        int failures = 0;
+        for (int k = 0; k < 2; k++) {
+                printf("%s %s %ux%u: %ld allocations\n", codec, names[k],
+                       width, height, counts[k]);
+                if (*expected[k] == -1) {
+                        *expected[k] = counts[k];
+                }
+                if (counts[k] != *expected[k] ||
+                    counts[k] > MAX_ALLOCATIONS) {
+                        fprintf(stderr, "FAIL: %s %s %ux%u made %ld "
+                                "allocations, expected %ld (at most %d)\n",
+                                codec, names[k], width, height, counts[k],
+                                *expected[k], MAX_ALLOCATIONS);
+                        failures++;
+                }
+        }
+        return failures;
+}
+
+int main(void)
+{
+        static const unsigned sizes[][2] = { { 64, 48 }, { 1026, 770 } };
+        int failures = 0;
+        compress40_set_threads(1);
+        for (int fixed = 0; fixed <= 1; fixed++) {
+                const char *codec = fixed ? "fixed" : "float";
+                long compress = -1, decompress = -1;
+                compress40_set_fixed_point(fixed);
+                for (int s = 0; s < 2; s++) {
+                        failures += check_size(codec, sizes[s][0],
+                                               sizes[s][1], &compress,
+                                               &decompress);
+                }
+        }
+        return failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,170 @@
+/*
+ *     batch_test.c
+ *     by Abhinav Mummameni (amumma01) and Rolando Ortega (rorteg02)
+ *
+ *     Test program, built and run by 'make test', for the batch mode of
+ *     40image, which it runs from the current directory. Compresses a batch
+ *     that mixes good images with a truncated one and one that is not an
+ *     image at all, then decompresses a batch that mixes good compressed
+ *     images with a truncated one and one whose header is bad. Each batch
+ *     must finish with a failure status, write a good output for every 
+ *     good file, and leave no output for the bad ones. A bad file must not
+ *     crash 40image, which now handles it on the worker thread that found 
+ *     it.
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include "assert.h"
+#include "testutil.h"
+
+#define GOOD 2
+
+static char dir[] = "/tmp/batch_testXXXXXX";
+
+/* Writes a width by height test image to path. Only the first keep bytes 
+ * of its pixels are written, so a keep below the full size makes a 
+ * truncated image. */
+static void make_image(const char *path, unsigned width, unsigned height,
+                       long keep)
+{
+        FILE *file = fopen(path, "wb");
+        assert(file != NULL);
+        Testutil_write_image(file, width, height, keep);
+        int closed = fclose(file);
+        assert(closed == 0);
+}
+
+/* Writes text to a new file at path */
+static void make_text(const char *path, const char *text)
+{
+        FILE *file = fopen(path, "wb");
+        assert(file != NULL);
+        fputs(text, file);
+        int closed = fclose(file);
+        assert(closed == 0);
+}
+
+/* Copies the first half of the file at from to a new file at to */
+static void truncate_copy(const char *from, const char *to)
+{
+        FILE *input = fopen(from, "rb");
+        FILE *output = fopen(to, "wb");
+        assert(input != NULL && output != NULL);
+        char buffer[1 << 16];
+        size_t n = fread(buffer, 1, sizeof(buffer), input);
+        fwrite(buffer, 1, n / 2, output);
+        fclose(input);
+        int closed = fclose(output);
+        assert(closed == 0);
+}
+
+/* Returns the size of the file at path, or -1 if there is none */
+static long file_size(const char *path)
+{
+        struct stat info;
+        return stat(path, &info) == 0 ? (long) info.st_size : -1;
+}
+
+/* Runs 40image with the given options on the files in dir named by names,
+ * and returns the number of failures: it must exit with status 1, not
+ * crash or succeed */
+static int run_batch(const char *options, const char *names[], int count)
+{
+        char command[4096];
+        int length = snprintf(command, sizeof(command), "./40image %s -b",
+                              options);
+        for (int k = 0; k < count; k++) {
+                length += snprintf(command + length, sizeof(command) - length,
+                                   " %s/%s", dir, names[k]);
+        }
+        snprintf(command + length, sizeof(command) - length,
+                 " 2>/dev/null");
+        assert(length < (int) sizeof(command) - 16);
+
+        int status = system(command);
+        if (status == -1 || !WIFEXITED(status) || WEXITSTATUS(status) != 1) {
+                fprintf(stderr, "FAIL: '%s' exited with status 0x%x, not "
+                        "1\n", command, (unsigned) status);
+                return 1;
+        }
+        return 0;
+}
+
+/* Checks the outputs of a batch: names[k] in dir must exist and not be empty
+ * for k below GOOD, and must not exist from then on. Returns the number of
+ * failures. */
+static int check_outputs(const char *names[], int count)
+{
+        int failures = 0;
+        for (int k = 0; k < count; k++) {
+                char path[256];
+                snprintf(path, sizeof(path), "%s/%s", dir, names[k]);
+                long size = file_size(path);
+                if (k < GOOD ? size <= 0 : size != -1) {
+                        fprintf(stderr, "FAIL: '%s' %s\n", path,
+                                k < GOOD ? "is missing or empty" :
+                                           "was left behind");
+                        failures++;
+                }
+        }
+        return failures;
+}
+
+int main(void)
+{
+        static const char *images[] = { "good1.ppm", "good2.ppm",
+                                        "truncated.ppm", "garbage.ppm" };
+        static const char *compressed[] = { "good1.c40", "good2.c40",
+                                            "truncated.c40", "garbage.c40" };
+        static const char *broken[] = { "good1.c40", "good2.c40",
+                                        "short.c40", "header.c40" };
+        static const char *decompressed[] = { "good1.ppm", "good2.ppm",
+                                              "short.ppm", "header.ppm" };
+        char path[256], from[256];
+        int failures = 0;
+
+        char *made = mkdtemp(dir);
+        assert(made != NULL);
+        snprintf(path, sizeof(path), "%s/good1.ppm", dir);
+        make_image(path, 64, 48, 64 * 48 * 3);
+        snprintf(path, sizeof(path), "%s/good2.ppm", dir);
+        make_image(path, 30, 20, 30 * 20 * 3);
+        snprintf(path, sizeof(path), "%s/truncated.ppm", dir);
+        make_image(path, 64, 48, 64 * 20 * 3 + 7);
+        snprintf(path, sizeof(path), "%s/garbage.ppm", dir);
+        make_text(path, "not an image\n");
+
+        failures += run_batch("-c", images, 4);
+        failures += check_outputs(compressed, 4);
+
+        /* The good images are removed, so their outputs must be new */
+        for (int k = 0; k < GOOD; k++) {
+                snprintf(path, sizeof(path), "%s/%s", dir, images[k]);
+                remove(path);
+        }
+        snprintf(from, sizeof(from), "%s/good1.c40", dir);
+        snprintf(path, sizeof(path), "%s/short.c40", dir);
+        truncate_copy(from, path);
+        snprintf(path, sizeof(path), "%s/header.c40", dir);
+        make_text(path, "COMP40 Compressed image format 9\n2 2\n");
+        failures += run_batch("-d", broken, 4);
+        failures += check_outputs(decompressed, 4);
+        printf("batch: %d failures\n", failures);
+
+        static const char *leftovers[] = { "good1.ppm", "good2.ppm",
+                "truncated.ppm", "garbage.ppm", "good1.c40", "good2.c40",
+                "truncated.c40", "garbage.c40", "short.c40", "short.ppm",
+                "header.c40", "header.ppm" };
+        for (unsigned k = 0; k < sizeof(leftovers) / sizeof(leftovers[0]);
+             k++) {
+                snprintf(path, sizeof(path), "%s/%s", dir, leftovers[k]);
+                remove(path);
+        }
+        rmdir(dir);
+        return failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
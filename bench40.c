@@ -0,0 +1,505 @@
+/*
+ *     bench40.c
+ *     by Abhinav Mummameni (amumma01) and Rolando Ortega (rorteg02)
+ *
+ *     Benchmark harness for the 40image codec, built and run by 'make bench'.
+ *     Generates synthetic PPM images of several sizes and kinds of content
+ *     (flat, gradients, noise, and a photograph-like mix), then times each
+ *     stage of the codec on its own, a whole image at a time, followed by
+ *     compress40 and decompress40 end to end. Results are printed to
+ *     standard output as CSV, one line per image and stage, with the time
+ *     per run, MB/s of raw pixels, and ns per block of the stage's size.
+ */
+
+#include <string.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <time.h>
+#include <unistd.h>
+#include "assert.h"
+#include "mem.h"
+#include "pnm.h"
+#include "compress40.h"
+#include "conversion.h"
+#include "codeword.h"
+#include "fixed.h"
+#include "outbuf.h"
+#include "parallel.h"
+#include "ppmstream.h"
+
+/* Every stage processes about this many pixels in total, so small images
+ * are run many times and big ones only once or twice */
+#define PIXELS_PER_STAGE (1L << 24)
+#define DENOMINATOR 255
+
+/* struct Image - A synthetic image. pixels holds height rows of width
+ * pixels; file holds the same image as a raw PPM */
+struct Image {
+        const char *kind;
+        unsigned width;
+        unsigned height;
+        struct Pnm_rgb *pixels;
+        FILE *file;
+};
+
+/* struct Buffers - Whole-image buffers for the stages between pixels and
+ * code words. fields holds CODEWORD_NFIELDS arrays of one value per block,
+ * and raster holds the image as raw PPM bytes. */
+struct Buffers {
+        int count;
+        int rows;
+        Compressed *blocks;
+        int32_t *fields;
+        unsigned char *codewords;
+        struct Pnm_rgb *pixels;
+        unsigned char *raster;
+        long row_bytes;
+        Fixed_T fixed;
+};
+
+typedef void Stage_fun(struct Image *image, struct Buffers *buffers);
+
+static unsigned long long seed = 40;
+
+/* A small linear congruential generator, so every run sees the same images */
+static unsigned next_random(void)
+{
+        seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+        return seed >> 33;
+}
+
+static unsigned clamp(long value)
+{
+        return value < 0 ? 0 : value > DENOMINATOR ? DENOMINATOR : value;
+}
+
+/***************************generate*********************************
+*
+* Fills the pixels of an image with synthetic content of the given kind
+*
+* Parameters: struct Image *image: the image, with kind, width, height and
+*                                  room for its pixels
+*
+* Expects: kind is "flat", "gradient", "noise" or "photo"
+*
+* Return: nothing
+*
+* Notes: "photo" is meant to look like a photograph to the codec: smooth
+*        shading, a few hard edges, and a little sensor noise
+*********************************************************************/
+static void generate(struct Image *image)
+{
+        unsigned w = image->width, h = image->height;
+        for (unsigned row = 0; row < h; row++) {
+                for (unsigned col = 0; col < w; col++) {
+                        struct Pnm_rgb *pixel = &image->pixels[(long) row * w +
+                                                               col];
+                        long r, g, b;
+                        if (strcmp(image->kind, "flat") == 0) {
+                                r = 90; g = 140; b = 200;
+                        } else if (strcmp(image->kind, "gradient") == 0) {
+                                r = 255L * col / w;
+                                g = 255L * row / h;
+                                b = 255L * (col + row) / (w + h);
+                        } else if (strcmp(image->kind, "noise") == 0) {
+                                unsigned bits = next_random();
+                                r = bits & 0xff;
+                                g = bits >> 8 & 0xff;
+                                b = bits >> 16 & 0xff;
+                        } else {
+                                long shade = 128 + 64 * (long) (col % 97) / 97
+                                                 - 48 * (long) (row % 61) / 61;
+                                long edge = ((col / 64 + row / 48) % 3) * 30;
+                                long grain = (long) (next_random() % 9) - 4;
+                                r = shade + edge + grain;
+                                g = shade - edge / 2 + grain;
+                                b = 255 - shade + grain;
+                        }
+                        pixel->red = clamp(r);
+                        pixel->green = clamp(g);
+                        pixel->blue = clamp(b);
+                }
+        }
+}
+
+/* Writes the pixels of an image to a temporary file as a raw PPM */
+static FILE *write_ppm(struct Image *image)
+{
+        FILE *file = tmpfile();
+        assert(file != NULL);
+        long row_bytes = Ppmstream_row_bytes(image->width, DENOMINATOR);
+        unsigned char *bytes = ALLOC(row_bytes);
+        Ppmstream_write_header(file, image->width, image->height,
+                               DENOMINATOR);
+        for (unsigned row = 0; row < image->height; row++) {
+                Ppmstream_pack_row(image->pixels + (long) row * image->width,
+                                   image->width, DENOMINATOR, bytes);
+                fwrite(bytes, 1, row_bytes, file);
+        }
+        FREE(bytes);
+        int flushed = fflush(file);
+        assert(flushed == 0);
+        return file;
+}
+
+/* Returns the time of a monotonic clock, in seconds */
+static double now(void)
+{
+        struct timespec time;
+        clock_gettime(CLOCK_MONOTONIC, &time);
+        return time.tv_sec + time.tv_nsec * 1e-9;
+}
+
+/* Runs a function with standard output sent to a file instead */
+static void with_stdout(FILE *file, void fun(FILE *input), FILE *input)
+{
+        fflush(stdout);
+        int saved = dup(STDOUT_FILENO);
+        assert(saved >= 0);
+        int redirected = dup2(fileno(file), STDOUT_FILENO);
+        assert(redirected >= 0);
+        rewind(input);
+        fun(input);
+        fflush(stdout);
+        int restored = dup2(saved, STDOUT_FILENO);
+        assert(restored >= 0);
+        close(saved);
+}
+
+/****************** Stages *******************/
+
+/* Reads the whole PPM with the ppmstream interface */
+static void stage_ppm_read(struct Image *image, struct Buffers *buffers)
+{
+        rewind(image->file);
+        Ppmstream_T source = Ppmstream_open(image->file);
+        for (unsigned row = 0; row < image->height; row++) {
+                Ppmstream_read_row(source, buffers->pixels +
+                                   (long) row * image->width);
+        }
+        Ppmstream_close(&source);
+}
+
+/* Converts every 2x2 block to its DCT coefficients and average chroma */
+static void stage_get_compressed(struct Image *image, struct Buffers *buffers)
+{
+        for (int row = 0; row < buffers->rows; row++) {
+                struct Pnm_rgb *top = image->pixels +
+                                      2L * row * image->width;
+                getCompressedRow(top, top + image->width, buffers->count,
+                                 DENOMINATOR,
+                                 buffers->blocks + (long) row *
+                                 buffers->count);
+        }
+}
+
+/* Quantizes every block's values and packs them into code words */
+static void stage_quantize_pack(struct Image *image, struct Buffers *buffers)
+{
+        long total = (long) buffers->count * buffers->rows;
+        (void) image;
+        for (int row = 0; row < buffers->rows; row++) {
+                long offset = (long) row * buffers->count;
+                struct Codeword_row fields =
+                        Codeword_row_at(buffers->fields, total, offset);
+                quantize_row(buffers->blocks + offset, buffers->count,
+                             fields);
+                Codeword_pack_row(fields, buffers->count,
+                                  buffers->codewords + 4 * offset);
+        }
+}
+
+/* Unpacks every code word and turns its fields back into block values */
+static void stage_unpack_dequantize(struct Image *image,
+                                    struct Buffers *buffers)
+{
+        long total = (long) buffers->count * buffers->rows;
+        (void) image;
+        for (int row = 0; row < buffers->rows; row++) {
+                long offset = (long) row * buffers->count;
+                struct Codeword_row fields =
+                        Codeword_row_at(buffers->fields, total, offset);
+                Codeword_unpack_row(buffers->codewords + 4 * offset,
+                                    buffers->count, fields);
+                dequantize_row(fields, buffers->count,
+                               buffers->blocks + offset);
+        }
+}
+
+/* Converts every block's values back to its 4 pixels */
+static void stage_set_pixels(struct Image *image, struct Buffers *buffers)
+{
+        for (int row = 0; row < buffers->rows; row++) {
+                struct Pnm_rgb *top = buffers->pixels +
+                                      2L * row * image->width;
+                setPixelsRow(buffers->blocks + (long) row * buffers->count,
+                             buffers->count, DENOMINATOR, top,
+                             top + image->width);
+        }
+}
+
+/* Packs every row of pixels as a raw PPM and writes it to /dev/null */
+static void stage_ppm_write(struct Image *image, struct Buffers *buffers)
+{
+        FILE *null = fopen("/dev/null", "w");
+        assert(null != NULL);
+        Outbuf_T out = Outbuf_new(null, 0);
+        Ppmstream_write_header(null, image->width, image->height,
+                               DENOMINATOR);
+        for (unsigned row = 0; row < image->height; row++) {
+                Ppmstream_pack_row(buffers->pixels +
+                                   (long) row * image->width, image->width,
+                                   DENOMINATOR, buffers->raster);
+                Outbuf_put_bytes(out, buffers->raster, buffers->row_bytes);
+        }
+        Outbuf_free(&out);
+        fclose(null);
+}
+
+/* Goes straight from pixels to code word fields with the fixed-point codec */
+static void stage_fixed_quantize(struct Image *image, struct Buffers *buffers)
+{
+        long total = (long) buffers->count * buffers->rows;
+        for (int row = 0; row < buffers->rows; row++) {
+                const struct Pnm_rgb *top = image->pixels +
+                                            2L * row * image->width;
+                Fixed_quantize_row(buffers->fixed, top, top + image->width,
+                                   buffers->count,
+                                   Codeword_row_at(buffers->fields, total,
+                                                   (long) row *
+                                                   buffers->count));
+        }
+}
+
+/* Decodes code word fields straight to raw pixels with the fixed-point
+ * codec's tables */
+static void stage_fixed_decode(struct Image *image, struct Buffers *buffers)
+{
+        long total = (long) buffers->count * buffers->rows;
+        (void) image;
+        for (int row = 0; row < buffers->rows; row++) {
+                unsigned char *top = buffers->raster +
+                                     2 * row * buffers->row_bytes;
+                Fixed_decode_row(buffers->fixed,
+                                 Codeword_row_at(buffers->fields, total,
+                                                 (long) row *
+                                                 buffers->count),
+                                 buffers->count, top,
+                                 top + buffers->row_bytes);
+        }
+}
+
+static FILE *compressed = NULL;
+
+/* compress40 from the PPM file, with the code words kept for decompress */
+static void stage_compress(struct Image *image, struct Buffers *buffers)
+{
+        (void) buffers;
+        if (compressed != NULL) {
+                fclose(compressed);
+        }
+        compressed = tmpfile();
+        assert(compressed != NULL);
+        with_stdout(compressed, compress40, image->file);
+}
+
+/* decompress40 from the code words of the last compress, to /dev/null */
+static void stage_decompress(struct Image *image, struct Buffers *buffers)
+{
+        (void) image;
+        (void) buffers;
+        assert(compressed != NULL);
+        FILE *null = fopen("/dev/null", "w");
+        assert(null != NULL);
+        with_stdout(null, decompress40, compressed);
+        fclose(null);
+}
+
+/* compress and decompress again, with 4 by 4 and 8 by 8 blocks (format 6)
+ * instead of 2 by 2 ones */
+static void stage_compress_4x4(struct Image *image, struct Buffers *buffers)
+{
+        compress40_set_block_size(4);
+        stage_compress(image, buffers);
+        compress40_set_block_size(2);
+}
+
+static void stage_compress_8x8(struct Image *image, struct Buffers *buffers)
+{
+        compress40_set_block_size(8);
+        stage_compress(image, buffers);
+        compress40_set_block_size(2);
+}
+
+/* Each stage, and the width and height in pixels of the blocks it works 
+ * on, which its ns per block is measured against */
+static const struct {
+        const char *name;
+        Stage_fun *run;
+        unsigned side;
+} stages[] = {
+        { "ppm_read",           stage_ppm_read,                 2 },
+        { "get_compressed",     stage_get_compressed,           2 },
+        { "quantize_pack",      stage_quantize_pack,            2 },
+        { "unpack_dequantize",  stage_unpack_dequantize,        2 },
+        { "set_pixels",         stage_set_pixels,               2 },
+        { "ppm_write",          stage_ppm_write,                2 },
+        { "fixed_quantize",     stage_fixed_quantize,           2 },
+        { "fixed_decode",       stage_fixed_decode,             2 },
+        { "compress",           stage_compress,                 2 },
+        { "decompress",         stage_decompress,               2 },
+        { "compress_4x4",       stage_compress_4x4,             4 },
+        { "decompress_4x4",     stage_decompress,               4 },
+        { "compress_8x8",       stage_compress_8x8,             8 },
+        { "decompress_8x8",     stage_decompress,               8 },
+};
+
+/***************************bench_image*********************************
+*
+* Times every stage on one image and prints a CSV line for each
+*
+* Parameters: struct Image *image: the image, with its pixels and PPM file
+*             long reps: how many times to run each stage, or 0 to pick a
+*                        count from the size of the image
+*
+* Return: nothing
+*
+* Notes: each stage is run once to warm up before it is timed. The stages
+*        run in codec order, so each one works on what the one before it
+*        produced. MB/s is always of the image's raw pixels (3 bytes each),
+*        so the stages can be compared with each other.
+*********************************************************************/
+static void bench_image(struct Image *image, long reps)
+{
+        long pixels = (long) image->width * image->height;
+        struct Buffers buffers;
+        buffers.count = image->width / 2;
+        buffers.rows = image->height / 2;
+        long total = (long) buffers.count * buffers.rows;
+        buffers.blocks = ALLOC(total * sizeof(*buffers.blocks));
+        buffers.fields = ALLOC(CODEWORD_NFIELDS * total *
+                               sizeof(*buffers.fields));
+        buffers.codewords = ALLOC(4 * total);
+        buffers.pixels = ALLOC(pixels * sizeof(*buffers.pixels));
+        buffers.row_bytes = Ppmstream_row_bytes(image->width, DENOMINATOR);
+        buffers.raster = ALLOC(buffers.row_bytes * image->height);
+        buffers.fixed = Fixed_new(DENOMINATOR);
+        if (reps <= 0) {
+                reps = PIXELS_PER_STAGE / pixels;
+                reps = reps < 1 ? 1 : reps;
+        }
+
+        for (size_t i = 0; i < sizeof(stages) / sizeof(stages[0]); i++) {
+                stages[i].run(image, &buffers);
+                double start = now();
+                for (long r = 0; r < reps; r++) {
+                        stages[i].run(image, &buffers);
+                }
+                double seconds = (now() - start) / reps;
+                unsigned side = stages[i].side;
+                long blocks = (long) (image->width / side) * 
+                              (image->height / side);
+                printf("%s,%u,%u,%s,%ld,%ld,%.9f,%.2f,%.2f\n", image->kind,
+                       image->width, image->height, stages[i].name, reps,
+                       blocks, seconds, 3.0 * pixels / seconds / 1e6,
+                       blocks > 0 ? seconds * 1e9 / blocks : 0.0);
+                fflush(stdout);
+        }
+
+        Fixed_free(&buffers.fixed);
+        FREE(buffers.blocks);
+        FREE(buffers.fields);
+        FREE(buffers.codewords);
+        FREE(buffers.pixels);
+        FREE(buffers.raster);
+}
+
+/***************************main**********************************
+*
+* Benchmarks the codec on every kind of synthetic image at every size
+*
+* Parameters: int argc: the number of arguments given
+*             char *argv[]: the command line arguments given
+*
+* Expects: '-s WxH' benchmarks only that size (both even and nonzero),
+*          '-r N' runs each stage N times, and '-t N' sets the number of
+*          threads for compress and decompress, where N = 0 means one per
+*          online processor
+*
+* Return: An int containing whether the program ran successfully
+*
+* Notes: prints a CSV header line, then one line per image and stage
+*********************************************************************/
+int main(int argc, char *argv[])
+{
+        static const char *kinds[] = { "flat", "gradient", "noise", "photo" };
+        unsigned sizes[][2] = { { 256, 256 }, { 1024, 768 },
+                                { 2048, 1536 } };
+        int nsizes = sizeof(sizes) / sizeof(sizes[0]);
+        long reps = 0;
+
+        for (int i = 1; i < argc; i++) {
+                char *end = NULL;
+                if (strcmp(argv[i], "-s") == 0 && i + 1 < argc) {
+                        unsigned long w = strtoul(argv[++i], &end, 10);
+                        unsigned long h = *end == 'x' ?
+                                          strtoul(end + 1, &end, 10) : 0;
+                        if (*end != '\0' || w == 0 || h == 0 || w % 2 != 0 ||
+                            h % 2 != 0) {
+                                fprintf(stderr, "%s: bad size '%s'\n",
+                                        argv[0], argv[i]);
+                                exit(1);
+                        }
+                        sizes[0][0] = w;
+                        sizes[0][1] = h;
+                        nsizes = 1;
+                } else if (strcmp(argv[i], "-r") == 0 && i + 1 < argc) {
+                        reps = strtol(argv[++i], &end, 10);
+                        if (*end != '\0' || reps <= 0) {
+                                fprintf(stderr, "%s: bad repetitions '%s'\n",
+                                        argv[0], argv[i]);
+                                exit(1);
+                        }
+                } else if (strcmp(argv[i], "-t") == 0 && i + 1 < argc) {
+                        long threads = strtol(argv[++i], &end, 10);
+                        if (*end != '\0' || threads < 0) {
+                                fprintf(stderr, "%s: bad thread count '%s'\n",
+                                        argv[0], argv[i]);
+                                exit(1);
+                        }
+                        compress40_set_threads(threads == 0 ?
+                                               Parallel_processors() :
+                                               (unsigned) threads);
+                } else {
+                        fprintf(stderr, "Usage: %s [-s WxH] [-r reps] "
+                                "[-t threads]\n", argv[0]);
+                        exit(1);
+                }
+        }
+
+        printf("image,width,height,stage,reps,blocks,seconds,mb_per_s,"
+               "ns_per_block\n");
+        for (int s = 0; s < nsizes; s++) {
+                for (size_t k = 0; k < sizeof(kinds) / sizeof(kinds[0]);
+                     k++) {
+                        struct Image image;
+                        image.kind = kinds[k];
+                        image.width = sizes[s][0];
+                        image.height = sizes[s][1];
+                        image.pixels = ALLOC((long) image.width *
+                                             image.height *
+                                             sizeof(*image.pixels));
+                        generate(&image);
+                        image.file = write_ppm(&image);
+                        bench_image(&image, reps);
+                        fclose(image.file);
+                        FREE(image.pixels);
+                }
+        }
+        if (compressed != NULL) {
+                fclose(compressed);
+        }
+
+        return EXIT_SUCCESS;
+}
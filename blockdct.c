@@ -0,0 +1,462 @@
+/*
+ *     blockdct.c
+ *     by Abhinav Mummameni (amumma01) and Rolando Ortega (rorteg02)
+ *
+ *     Implementation of the Blockdct interface. encode_blocks and
+ *     decode_blocks are written once, for any block size and layout, and
+ *     always inlined into a pair of kernels per block size that pass them
+ *     constants, so the compiler unrolls every loop over the pixels or the
+ *     coefficients of a block for its size. Blockdct_new picks the pair.
+ *
+ *     The DCT is the orthonormal two-dimensional DCT-II, done as a DCT of
+ *     the columns and then of the rows. Only the first USED rows and columns
+ *     of coefficients can be in the layout, so the others are never
+ *     computed, and never transformed back.
+ */
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <math.h>
+#include "assert.h"
+#include "mem.h"
+#include "chroma.h"
+#include "blockdct.h"
+
+#define T Blockdct_T
+#define MAX_SIZE 8
+#define MAX_DENOMINATOR 65535
+#define LUMA_LEVELS 255
+/* An AC coefficient, divided by the block size, of this much or more is
+ * quantized to the largest value its field holds */
+#define AC_RANGE 0.5
+
+/* The layout of each block size: how many AC coefficients, of how many
+ * bits, and how many rows and columns of coefficients they come from */
+#define AC_COUNT_4 8
+#define AC_BITS_4 6
+#define USED_4 4
+#define AC_COUNT_8 16
+#define AC_BITS_8 7
+#define USED_8 6
+
+/* Each layout must fill whole bytes */
+typedef char Blockdct_layouts_are_valid[
+        (16 + AC_COUNT_4 * AC_BITS_4) % 8 == 0 &&
+        (16 + AC_COUNT_8 * AC_BITS_8) % 8 == 0 ? 1 : -1];
+
+/* The kernels are inlined where their sizes are constants, and every loop
+ * over a block is unrolled, since GCC's -O2 leaves nested loops alone */
+#if defined(__GNUC__)
+#define SPECIALIZE static inline __attribute__((always_inline))
+#else
+#define SPECIALIZE static inline
+#endif
+#if defined(__GNUC__) && !defined(__clang__) && __GNUC__ >= 8
+#define UNROLL _Pragma("GCC unroll 8")
+#else
+#define UNROLL
+#endif
+
+typedef void Encode_fun(T codec, const struct Pnm_rgb *pixels, long stride,
+                        int count, unsigned char *bytes);
+typedef void Decode_fun(T codec, const unsigned char *bytes, int count,
+                        unsigned char *raster, long row_bytes);
+
+/* struct T - basis[u][x] is the x-th value of the u-th DCT basis vector for
+ * blocks of size pixels on a side, and zigzag[i] holds the row and column
+ * of the i-th coefficient in zigzag order. encode and decode are the
+ * kernels for the block size. */
+struct T {
+        unsigned size;
+        int bytes;
+        float denominator;
+        float basis[MAX_SIZE][MAX_SIZE];
+        unsigned char zigzag[MAX_SIZE * MAX_SIZE][2];
+        Encode_fun *encode;
+        Decode_fun *decode;
+};
+
+/* struct Bitwriter - Packs fields into bytes, most significant bit first.
+ * The last count bits of held have yet to be stored. */
+struct Bitwriter {
+        uint64_t held;
+        int count;
+        unsigned char *bytes;
+};
+
+static inline void put_bits(struct Bitwriter *writer, uint32_t value,
+                            int width)
+{
+        writer->held = writer->held << width | (value & ((1u << width) - 1));
+        writer->count += width;
+        while (writer->count >= 8) {
+                writer->count -= 8;
+                *writer->bytes++ = writer->held >> writer->count;
+        }
+}
+
+/* struct Bitreader - Unpacks fields from bytes, most significant bit first.
+ * The last count bits of held have yet to be read. */
+struct Bitreader {
+        uint64_t held;
+        int count;
+        const unsigned char *bytes;
+};
+
+static inline uint32_t get_bits(struct Bitreader *reader, int width)
+{
+        while (reader->count < width) {
+                reader->held = reader->held << 8 | *reader->bytes++;
+                reader->count += 8;
+        }
+        reader->count -= width;
+        return (reader->held >> reader->count) & ((1u << width) - 1);
+}
+
+static inline int32_t get_signed(struct Bitreader *reader, int width)
+{
+        int32_t value = get_bits(reader, width);
+        return value >= 1 << (width - 1) ? value - (1 << width) : value;
+}
+
+/* Rounds a value to the nearest integer in [low, limit] */
+static inline int32_t quantize(float value, int32_t low, int32_t limit)
+{
+        if (value <= low) {
+                return low;
+        } else if (value >= limit) {
+                return limit;
+        }
+        return value < 0.0f ? (int32_t) (value - 0.5f) : 
+                              (int32_t) (value + 0.5f);
+}
+
+/* Scales a channel in [0, 1] to a byte, rounding and clamping */
+static inline unsigned char channel_byte(float value)
+{
+        value *= 255.0f;
+        return value <= 0.0f ? 0 : value >= 255.0f ? 255 : value + 0.5f;
+}
+
+/***************************encode_blocks************************************
+*
+* Encodes a row of blocks of n by n pixels, with ac_count AC coefficients of
+* ac_bits each, which come from the first used rows and columns of
+* coefficients. Always inlined with constant n, ac_count, ac_bits and used.
+*
+* Notes: Every loop over a row of the block is innermost, so the compiler 
+*        can unroll and vectorize it. The chroma of a block only needs its 
+*        average, which comes from the sums of its red, green and blue.
+*********************************************************************/
+SPECIALIZE void encode_blocks(T codec, const struct Pnm_rgb *pixels,
+                              long stride, int count, unsigned char *bytes,
+                              const int n, const int ac_count,
+                              const int ac_bits, const int used)
+{
+        const int32_t levels = (1 << (ac_bits - 1)) - 1;
+        const float ac_scale = levels / AC_RANGE / n;
+        const int word_bytes = (16 + ac_count * ac_bits) / 8;
+        const float scale = 1.0f / codec->denominator;
+        for (int k = 0; k < count; k++) {
+                float luma[MAX_SIZE][MAX_SIZE];
+                float total_r = 0.0f, total_g = 0.0f, total_b = 0.0f;
+                UNROLL
+                for (int y = 0; y < n; y++) {
+                        const struct Pnm_rgb *pixel = pixels + y * stride +
+                                                      (long) k * n;
+                        /* Channels are at most MAX_DENOMINATOR, so they
+                         * convert from int, which is quicker */
+                        UNROLL
+                        for (int x = 0; x < n; x++) {
+                                float r = (int) pixel[x].red * scale;
+                                float g = (int) pixel[x].green * scale;
+                                float b = (int) pixel[x].blue * scale;
+                                luma[y][x] = 0.299f * r + 0.587f * g +
+                                             0.114f * b;
+                                total_r += r;
+                                total_g += g;
+                                total_b += b;
+                        }
+                }
+
+                /* The DCT of the columns, then of the rows */
+                float columns[MAX_SIZE][MAX_SIZE], coeffs[MAX_SIZE][MAX_SIZE];
+                UNROLL
+                for (int u = 0; u < used; u++) {
+                        UNROLL
+                        for (int x = 0; x < n; x++) {
+                                columns[u][x] = 0.0f;
+                        }
+                        UNROLL
+                        for (int y = 0; y < n; y++) {
+                                UNROLL
+                                for (int x = 0; x < n; x++) {
+                                        columns[u][x] += codec->basis[u][y] *
+                                                         luma[y][x];
+                                }
+                        }
+                        UNROLL
+                        for (int v = 0; v < used; v++) {
+                                coeffs[u][v] = 0.0f;
+                        }
+                        UNROLL
+                        for (int x = 0; x < n; x++) {
+                                UNROLL
+                                for (int v = 0; v < used; v++) {
+                                        coeffs[u][v] += columns[u][x] *
+                                                        codec->basis[v][x];
+                                }
+                        }
+                }
+
+                float area = n * n;
+                float pb = (-0.168736f * total_r - 0.331264f * total_g + 
+                            0.5f * total_b) / area;
+                float pr = (0.5f * total_r - 0.418688f * total_g - 
+                            0.081312f * total_b) / area;
+                /* The DC coefficient is n times the average luma */
+                struct Bitwriter writer = { 0, 0, bytes + k * word_bytes };
+                put_bits(&writer, quantize(coeffs[0][0] / n * LUMA_LEVELS,
+                                           0, LUMA_LEVELS), 8);
+                put_bits(&writer, Chroma_index(pb), 4);
+                put_bits(&writer, Chroma_index(pr), 4);
+                UNROLL
+                for (int i = 1; i <= ac_count; i++) {
+                        const unsigned char *at = codec->zigzag[i];
+                        put_bits(&writer, quantize(coeffs[at[0]][at[1]] *
+                                                   ac_scale, -levels,
+                                                   levels), ac_bits);
+                }
+        }
+}
+
+/***************************decode_blocks************************************
+*
+* Decodes a row of blocks of n by n pixels, laid out as for encode_blocks.
+* Always inlined with constant n, ac_count, ac_bits and used.
+*
+*********************************************************************/
+SPECIALIZE void decode_blocks(T codec, const unsigned char *bytes, int count,
+                              unsigned char *raster, long row_bytes,
+                              const int n, const int ac_count,
+                              const int ac_bits, const int used)
+{
+        const int32_t levels = (1 << (ac_bits - 1)) - 1;
+        const float ac_unscale = AC_RANGE * n / levels;
+        const int word_bytes = (16 + ac_count * ac_bits) / 8;
+        for (int k = 0; k < count; k++) {
+                struct Bitreader reader = { 0, 0, bytes + k * word_bytes };
+                float coeffs[MAX_SIZE][MAX_SIZE];
+                UNROLL
+                for (int u = 0; u < used; u++) {
+                        UNROLL
+                        for (int v = 0; v < used; v++) {
+                                coeffs[u][v] = 0.0f;
+                        }
+                }
+                coeffs[0][0] = get_bits(&reader, 8) * (float) n /
+                               LUMA_LEVELS;
+                float pb = Chroma_value(get_bits(&reader, 4));
+                float pr = Chroma_value(get_bits(&reader, 4));
+                UNROLL
+                for (int i = 1; i <= ac_count; i++) {
+                        const unsigned char *at = codec->zigzag[i];
+                        coeffs[at[0]][at[1]] = get_signed(&reader, ac_bits) *
+                                               ac_unscale;
+                }
+
+                /* The inverse DCT of the rows, then of the columns */
+                float rows[MAX_SIZE][MAX_SIZE], luma[MAX_SIZE][MAX_SIZE];
+                UNROLL
+                for (int u = 0; u < used; u++) {
+                        UNROLL
+                        for (int x = 0; x < n; x++) {
+                                rows[u][x] = 0.0f;
+                        }
+                        UNROLL
+                        for (int v = 0; v < used; v++) {
+                                UNROLL
+                                for (int x = 0; x < n; x++) {
+                                        rows[u][x] += coeffs[u][v] *
+                                                      codec->basis[v][x];
+                                }
+                        }
+                }
+                UNROLL
+                for (int y = 0; y < n; y++) {
+                        UNROLL
+                        for (int x = 0; x < n; x++) {
+                                luma[y][x] = 0.0f;
+                        }
+                        UNROLL
+                        for (int u = 0; u < used; u++) {
+                                UNROLL
+                                for (int x = 0; x < n; x++) {
+                                        luma[y][x] += codec->basis[u][y] *
+                                                      rows[u][x];
+                                }
+                        }
+                }
+
+                float red = 1.402f * pr;
+                float green = -0.344136f * pb - 0.714136f * pr;
+                float blue = 1.772f * pb;
+                UNROLL
+                for (int y = 0; y < n; y++) {
+                        unsigned char *pixel = raster + y * row_bytes +
+                                               3L * k * n;
+                        UNROLL
+                        for (int x = 0; x < n; x++) {
+                                pixel[3 * x] = channel_byte(luma[y][x] + 
+                                                            red);
+                                pixel[3 * x + 1] = channel_byte(luma[y][x] +
+                                                                green);
+                                pixel[3 * x + 2] = channel_byte(luma[y][x] +
+                                                                blue);
+                        }
+                }
+        }
+}
+
+/* The kernels of each block size */
+static void encode_4(T codec, const struct Pnm_rgb *pixels, long stride,
+                     int count, unsigned char *bytes)
+{
+        encode_blocks(codec, pixels, stride, count, bytes, 4, AC_COUNT_4,
+                      AC_BITS_4, USED_4);
+}
+
+static void decode_4(T codec, const unsigned char *bytes, int count,
+                     unsigned char *raster, long row_bytes)
+{
+        decode_blocks(codec, bytes, count, raster, row_bytes, 4, AC_COUNT_4,
+                      AC_BITS_4, USED_4);
+}
+
+static void encode_8(T codec, const struct Pnm_rgb *pixels, long stride,
+                     int count, unsigned char *bytes)
+{
+        encode_blocks(codec, pixels, stride, count, bytes, 8, AC_COUNT_8,
+                      AC_BITS_8, USED_8);
+}
+
+static void decode_8(T codec, const unsigned char *bytes, int count,
+                     unsigned char *raster, long row_bytes)
+{
+        decode_blocks(codec, bytes, count, raster, row_bytes, 8, AC_COUNT_8,
+                      AC_BITS_8, USED_8);
+}
+
+/***************************Blockdct_new**********************************
+*
+* Creates the codec for one block size
+*
+* Parameters: unsigned size: the number of pixels on a side of each block
+*             unsigned denominator: the denominator of the images to encode
+*
+* Expects: size is 4 or 8, and denominator is between 1 and 65535; both are
+*          checked runtime errors
+*
+* Return: the new codec, which the caller must free with Blockdct_free
+*
+* Notes: Checks that the AC coefficients of the layout all lie in the rows
+*        and columns of coefficients that the kernels compute
+*********************************************************************/
+T Blockdct_new(unsigned size, unsigned denominator)
+{
+        assert(size == 4 || size == 8);
+        assert(denominator > 0 && denominator <= MAX_DENOMINATOR);
+        T codec;
+        NEW(codec);
+        codec->size = size;
+        codec->denominator = denominator;
+        int ac_count, used;
+        if (size == 4) {
+                codec->bytes = (16 + AC_COUNT_4 * AC_BITS_4) / 8;
+                codec->encode = encode_4;
+                codec->decode = decode_4;
+                ac_count = AC_COUNT_4;
+                used = USED_4;
+        } else {
+                codec->bytes = (16 + AC_COUNT_8 * AC_BITS_8) / 8;
+                codec->encode = encode_8;
+                codec->decode = decode_8;
+                ac_count = AC_COUNT_8;
+                used = USED_8;
+        }
+
+        const double pi = acos(-1.0);
+        for (unsigned u = 0; u < size; u++) {
+                double scale = sqrt((u == 0 ? 1.0 : 2.0) / size);
+                for (unsigned x = 0; x < size; x++) {
+                        codec->basis[u][x] = scale * cos((2 * x + 1) * u *
+                                                         pi / (2 * size));
+                }
+        }
+
+        /* Each diagonal in turn, alternating directions */
+        int i = 0;
+        for (unsigned diagonal = 0; diagonal < 2 * size - 1; diagonal++) {
+                for (unsigned step = 0; step <= diagonal; step++) {
+                        unsigned u = diagonal % 2 == 0 ? diagonal - step :
+                                                         step;
+                        unsigned v = diagonal - u;
+                        if (u < size && v < size) {
+                                codec->zigzag[i][0] = u;
+                                codec->zigzag[i][1] = v;
+                                i++;
+                        }
+                }
+        }
+        for (i = 0; i <= ac_count; i++) {
+                assert(codec->zigzag[i][0] < used &&
+                       codec->zigzag[i][1] < used);
+        }
+        return codec;
+}
+
+void Blockdct_free(T *codec)
+{
+        assert(codec != NULL && *codec != NULL);
+        FREE(*codec);
+}
+
+unsigned Blockdct_size(T codec)
+{
+        assert(codec != NULL);
+        return codec->size;
+}
+
+int Blockdct_bytes(T codec)
+{
+        assert(codec != NULL);
+        return codec->bytes;
+}
+
+void Blockdct_encode_row(T codec, const struct Pnm_rgb *pixels, long stride,
+                         int count, unsigned char *bytes)
+{
+        assert(codec != NULL && pixels != NULL && bytes != NULL);
+        codec->encode(codec, pixels, stride, count, bytes);
+}
+
+void Blockdct_decode_row(T codec, const unsigned char *bytes, int count,
+                         unsigned char *raster, long row_bytes)
+{
+        assert(codec != NULL && bytes != NULL && raster != NULL);
+        codec->decode(codec, bytes, count, raster, row_bytes);
+}
+
+#undef UNROLL
+#undef SPECIALIZE
+#undef USED_8
+#undef AC_BITS_8
+#undef AC_COUNT_8
+#undef USED_4
+#undef AC_BITS_4
+#undef AC_COUNT_4
+#undef AC_RANGE
+#undef LUMA_LEVELS
+#undef MAX_DENOMINATOR
+#undef MAX_SIZE
+#undef T
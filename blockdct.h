@@ -0,0 +1,58 @@
+/*
+ *     blockdct.h
+ *     by Abhinav Mummameni (amumma01) and Rolando Ortega (rorteg02)
+ *
+ *     Interface for the codec of "COMP40 Compressed image format 6", which
+ *     works on square blocks of 4x4 or 8x8 pixels instead of 2x2. The luma
+ *     of each block goes through a two-dimensional DCT; its average and its
+ *     first AC coefficients in zigzag order are kept, along with the
+ *     indices of the block's average chroma. The code word layout depends on
+ *     the block size:
+ *
+ *         4x4: 8 bytes:  a (8 bits), pb_bar (4), pr_bar (4), and 8 AC
+ *                        coefficients of 6 bits each
+ *         8x8: 16 bytes: a (8 bits), pb_bar (4), pr_bar (4), and 16 AC
+ *                        coefficients of 7 bits each
+ *
+ *     The fields are packed in that order from the most significant bit,
+ *     and each code word is stored in big endian order. a is the average
+ *     luma times 255, and the AC coefficients are signed. Each block size
+ *     has its own kernels, with the size built in, chosen once when the
+ *     codec is created.
+ */
+
+#ifndef BLOCKDCT_INCLUDED
+#define BLOCKDCT_INCLUDED
+
+#include "pnm.h"
+
+#define T Blockdct_T
+typedef struct T *T;
+
+/* Creates the codec for blocks of size by size pixels, compressing images
+ * with the given denominator and decompressing them to a denominator of
+ * 255. Checked runtime error if size is not 4 or 8, or denominator is 0. */
+extern T    Blockdct_new (unsigned size, unsigned denominator);
+extern void Blockdct_free(T *codec);
+
+/* The number of pixels on a side of each block, and of bytes in each code
+ * word */
+extern unsigned Blockdct_size (T codec);
+extern int      Blockdct_bytes(T codec);
+
+/* Encodes the count blocks covered by size rows of pixels, the first at
+ * pixels and each stride pixels after the last, into count code words at
+ * bytes */
+extern void Blockdct_encode_row(T codec, const struct Pnm_rgb *pixels,
+                                long stride, int count, unsigned char *bytes);
+
+/* Decodes count code words into the size rows of raw 8-bit pixels (as in a
+ * P6 raster) that their blocks cover, the first at raster and each
+ * row_bytes after the last. Each row must have room for size * count
+ * pixels. */
+extern void Blockdct_decode_row(T codec, const unsigned char *bytes,
+                                int count, unsigned char *raster,
+                                long row_bytes);
+
+#undef T
+#endif
@@ -0,0 +1,297 @@
+/*
+ *     chroma.c
+ *     by Abhinav Mummameni (amumma01) and Rolando Ortega (rorteg02)
+ *
+ *     Implementation of the chroma interface. The 16 levels are the ones 
+ *     libarith40 uses, copied here as constants, and the index of a value 
+ *     is that of its nearest level, the first one on a tie, just as with
+ *     Arith40_index_of_chroma. The index never goes down as the value goes
+ *     up, which makes the index of x the number of thresholds t[1..15] that
+ *     x has reached, where t[k] is the smallest float whose index is at 
+ *     least k. The thresholds are found once, by bisecting over the floats 
+ *     in [-1, 1] with nearest_level, so every answer in that range, which 
+ *     holds any average chroma, is bit-for-bit that of a search for the
+ *     nearest level. (Far outside it, rounding makes every level look 
+ *     equally near and the search falls back to 0.)
+ */
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <pthread.h>
+#include <math.h>
+#include "assert.h"
+#include "chroma.h"
+#if defined(__GNUC__) && defined(__x86_64__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+/* The lookup table splits [LUT_MIN, LUT_MAX), which covers every average
+ * chroma, into LUT_CELLS cells */
+#define LUT_CELLS 4096
+#define LUT_MIN (-0.5f)
+#define LUT_MAX 0.5f
+
+/* levels[i] is the chroma value of index i, as in Arith40_chroma_of_index */
+static const float levels[CHROMA_LEVELS] = {
+        -0.35, -0.20, -0.15, -0.10, -0.077, -0.055, -0.033, -0.011,
+         0.011, 0.033, 0.055, 0.077,  0.10,  0.15,  0.20,  0.35
+};
+
+/* thresholds[k] is the smallest float with an index of at least k; 
+ * thresholds[0] is never used. lut[c] is the index of the first float in 
+ * cell c. */
+static float thresholds[CHROMA_LEVELS];
+static unsigned char lut[LUT_CELLS];
+static pthread_once_t tables_once = PTHREAD_ONCE_INIT;
+
+/* Maps floats to integers in the same order, so bisection can work on ints */
+static int32_t float_order(float x)
+{
+        int32_t bits;
+        memcpy(&bits, &x, sizeof(bits));
+        return bits >= 0 ? bits : INT32_MIN - bits;
+}
+
+static float order_float(int32_t order)
+{
+        int32_t bits = order >= 0 ? order : INT32_MIN - order;
+        float x;
+        memcpy(&x, &bits, sizeof(x));
+        return x;
+}
+
+/* Returns the index of the level nearest to x, the first one on a tie */
+static unsigned nearest_level(float x)
+{
+        unsigned nearest = 0;
+        for (unsigned i = 1; i < CHROMA_LEVELS; i++) {
+                if (fabsf(x - levels[i]) < fabsf(x - levels[nearest])) {
+                        nearest = i;
+                }
+        }
+        return nearest;
+}
+
+/* Returns the smallest float in [-1, 1] whose index is at least level */
+static float find_threshold(unsigned level)
+{
+        int64_t lo = float_order(-1.0f);   /* index(lo) < level */
+        int64_t hi = float_order(1.0f);    /* index(hi) >= level */
+        if (nearest_level(order_float(lo)) >= level) {
+                return -1.0f;
+        }
+        while (hi - lo > 1) {
+                int64_t mid = lo + (hi - lo) / 2;
+                if (nearest_level(order_float(mid)) >= level) {
+                        hi = mid;
+                } else {
+                        lo = mid;
+                }
+        }
+        return order_float(hi);
+}
+
+/* Counts the thresholds that x has reached, starting from a guess */
+static inline unsigned count_thresholds(float x, unsigned index)
+{
+        while (index > 0 && x < thresholds[index]) {
+                index--;
+        }
+        while (index < CHROMA_LEVELS - 1 && x >= thresholds[index + 1]) {
+                index++;
+        }
+        return index;
+}
+
+static void build_tables(void)
+{
+        for (unsigned level = 1; level < CHROMA_LEVELS; level++) {
+                thresholds[level] = find_threshold(level);
+        }
+        for (int cell = 0; cell < LUT_CELLS; cell++) {
+                float start = LUT_MIN + (LUT_MAX - LUT_MIN) * cell / LUT_CELLS;
+                lut[cell] = count_thresholds(start, 0);
+        }
+}
+
+/***************************Chroma_index**********************************
+*
+* Quantizes a chroma value to the index of the nearest chroma level
+*
+* Parameters: float x: an average chroma value
+*
+* Return: the index of the nearest level, the same as 
+*         Arith40_index_of_chroma(x)
+*
+* Notes: The cells of the lookup table are much narrower than the gaps 
+*        between thresholds, so the table's guess is almost always right, 
+*        and is off by at most one level when x and a threshold share a 
+*        cell. Values outside the table start from its nearest cell.
+*
+*********************************************************************/
+unsigned Chroma_index(float x)
+{
+        pthread_once(&tables_once, build_tables);
+        float position = (x - LUT_MIN) * (LUT_CELLS / (LUT_MAX - LUT_MIN));
+        int cell = position <= 0 ? 0 : position >= LUT_CELLS - 1 ? 
+                                   LUT_CELLS - 1 : (int) position;
+        return count_thresholds(x, lut[cell]);
+}
+
+/***************************Chroma_threshold*********************************
+*
+* Returns the smallest chroma value in [-1, 1] whose index is at least level,
+* so that other scales (like the fixed-point compressor's) can quantize 
+* without converting back to floats
+*
+*********************************************************************/
+float Chroma_threshold(unsigned level)
+{
+        assert(level > 0 && level < CHROMA_LEVELS);
+        pthread_once(&tables_once, build_tables);
+        return thresholds[level];
+}
+
+/***************************Chroma_value**********************************
+*
+* Returns the chroma value of an index, as Arith40_chroma_of_index does
+*
+*********************************************************************/
+float Chroma_value(unsigned index)
+{
+        assert(index < CHROMA_LEVELS);
+        pthread_once(&tables_once, build_tables);
+        return levels[index];
+}
+
+#if defined(__SSE2__)
+
+/* Counts the thresholds reached by 4 values at a time. A compare sets a 
+ * lane to -1 when it is true, so subtracting each compare counts them. */
+static long sse2_index_row(const double *chroma, long stride, long count,
+                           int *indices)
+{
+        long i;
+        for (i = 0; i + 4 <= count; i += 4) {
+                const double *p = chroma + i * stride;
+                __m128 low = _mm_cvtpd_ps(_mm_set_pd(p[stride], p[0]));
+                __m128 high = _mm_cvtpd_ps(_mm_set_pd(p[3 * stride], 
+                                                      p[2 * stride]));
+                __m128 x = _mm_movelh_ps(low, high);
+                __m128i index = _mm_setzero_si128();
+                for (int level = 1; level < CHROMA_LEVELS; level++) {
+                        __m128 reached = _mm_cmpge_ps(x, 
+                                        _mm_set1_ps(thresholds[level]));
+                        index = _mm_sub_epi32(index, 
+                                              _mm_castps_si128(reached));
+                }
+                _mm_storeu_si128((__m128i *) (indices + i), index);
+        }
+        return i;
+}
+
+#endif /* __SSE2__ */
+
+#if defined(__GNUC__) && defined(__x86_64__)
+#define AVX2 __attribute__((target("avx2")))
+
+/* Counts the thresholds reached by 8 values at a time */
+AVX2 static long avx2_index_row(const double *chroma, long stride, 
+                                long count, int *indices)
+{
+        long i;
+        for (i = 0; i + 8 <= count; i += 8) {
+                const double *p = chroma + i * stride;
+                __m128 low = _mm256_cvtpd_ps(_mm256_set_pd(p[3 * stride],
+                                p[2 * stride], p[stride], p[0]));
+                __m128 high = _mm256_cvtpd_ps(_mm256_set_pd(p[7 * stride],
+                                p[6 * stride], p[5 * stride], p[4 * stride]));
+                __m256 x = _mm256_insertf128_ps(_mm256_castps128_ps256(low),
+                                                high, 1);
+                __m256i index = _mm256_setzero_si256();
+                for (int level = 1; level < CHROMA_LEVELS; level++) {
+                        __m256 reached = _mm256_cmp_ps(x, 
+                                        _mm256_set1_ps(thresholds[level]),
+                                        _CMP_GE_OQ);
+                        index = _mm256_sub_epi32(index, 
+                                                 _mm256_castps_si256(reached));
+                }
+                _mm256_storeu_si256((__m256i *) (indices + i), index);
+        }
+        return i;
+}
+
+#undef AVX2
+#define HAVE_AVX2_KERNELS 1
+#endif
+
+/***************************Chroma_index_row*********************************
+*
+* Quantizes a row of chroma values
+*
+* Parameters: const double *chroma: the first chroma value
+*             long stride: the number of doubles from one value to the next
+*             long count: the number of values
+*             int *indices: where to store the index of each value
+*
+* Expects: chroma and indices are not NULL and count is not negative, checked
+*          runtime errors
+*
+* Return: nothing, but stores the same indices as Chroma_index would
+*
+* Notes: SSE2 handles 4 values at a time and AVX2, picked at runtime when the
+*        CPU supports it, handles 8. The rest use Chroma_index.
+*
+*********************************************************************/
+void Chroma_index_row(const double *chroma, long stride, long count, 
+                      int *indices)
+{
+        assert(chroma != NULL && indices != NULL && count >= 0);
+        pthread_once(&tables_once, build_tables);
+        long done = 0;
+#if defined(HAVE_AVX2_KERNELS)
+        if (__builtin_cpu_supports("avx2")) {
+                done = avx2_index_row(chroma, stride, count, indices);
+        }
+#endif
+#if defined(__SSE2__)
+        if (done == 0) {
+                done = sse2_index_row(chroma, stride, count, indices);
+        }
+#endif
+        for (long i = done; i < count; i++) {
+                indices[i] = Chroma_index(chroma[i * stride]);
+        }
+}
+
+/***************************Chroma_value_row*********************************
+*
+* Looks up the chroma values of a row of indices
+*
+* Parameters: const int *indices: the indices
+*             long count: the number of indices
+*             double *chroma: where to store the first chroma value
+*             long stride: the number of doubles from one value to the next
+*
+* Expects: indices and chroma are not NULL, count is not negative, and every
+*          index is below CHROMA_LEVELS, checked runtime errors
+*
+*********************************************************************/
+void Chroma_value_row(const int *indices, long count, double *chroma, 
+                      long stride)
+{
+        assert(indices != NULL && chroma != NULL && count >= 0);
+        pthread_once(&tables_once, build_tables);
+        for (long i = 0; i < count; i++) {
+                assert((unsigned) indices[i] < CHROMA_LEVELS);
+                chroma[i * stride] = levels[indices[i]];
+        }
+}
+
+#undef HAVE_AVX2_KERNELS
+#undef LUT_CELLS
+#undef LUT_MIN
+#undef LUT_MAX
@@ -0,0 +1,42 @@
+/*
+ *     chroma.h
+ *     by Abhinav Mummameni (amumma01) and Rolando Ortega (rorteg02)
+ *
+ *     Interface for quantizing average chroma values to the 4-bit indices of
+ *     a code word, and back. Gives exactly the same answers as 
+ *     Arith40_index_of_chroma and Arith40_chroma_of_index, from the same 16
+ *     levels kept as constants, but without libarith40 or a search for each
+ *     value: indices come from a fine-grained lookup table, or, for a whole
+ *     row at a time, from counting the thresholds each value reaches with 
+ *     SIMD compares.
+ */
+
+#ifndef CHROMA_INCLUDED
+#define CHROMA_INCLUDED
+
+/* The number of chroma indices */
+#define CHROMA_LEVELS 16
+
+/* The index of the chroma level nearest to x */
+extern unsigned Chroma_index(float x);
+
+/* The smallest chroma value in [-1, 1] whose index is at least level. 
+ * Checked runtime error if level is not between 1 and CHROMA_LEVELS - 1. */
+extern float    Chroma_threshold(unsigned level);
+
+/* The chroma value of an index. Checked runtime error if index is not below
+ * CHROMA_LEVELS. */
+extern float    Chroma_value(unsigned index);
+
+/* Stores the index of count chroma values in indices. The values are 
+ * stride doubles apart, so chroma can point into an array of structs; each
+ * is rounded to a float first, just as when calling Chroma_index. */
+extern void     Chroma_index_row(const double *chroma, long stride, long count,
+                                 int *indices);
+
+/* Stores the chroma value of count indices, stride doubles apart, starting 
+ * at chroma. Checked runtime error if any index is not below CHROMA_LEVELS.*/
+extern void     Chroma_value_row(const int *indices, long count, double *chroma,
+                                 long stride);
+
+#endif
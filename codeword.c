@@ -0,0 +1,247 @@
+/*
+ *     codeword.c
+ *     by Abhinav Mummameni (amumma01) and Rolando Ortega (rorteg02)
+ *
+ *     Implementation of the row functions of the codeword.h interface. Each
+ *     vector lane holds one code word, and the per-field shifts and masks
+ *     are generated from CODEWORD_FIELDS, just like the inline functions in
+ *     the header, so the bytes are exactly those of Codeword_pack. SSE2
+ *     handles 4 code words at a time and is always available on x86-64;
+ *     AVX2 handles 8 and is picked at runtime when the CPU supports it. Any
+ *     leftover code words (and non-x86 builds) use the scalar functions.
+ */
+
+#include <stdlib.h>
+#include "assert.h"
+#include "codeword.h"
+#if defined(__GNUC__) && defined(__x86_64__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+/* Stores a code word at bytes in big endian order */
+static inline void store_codeword(uint32_t word, unsigned char *bytes)
+{
+        bytes[0] = word >> 24;
+        bytes[1] = word >> 16;
+        bytes[2] = word >> 8;
+        bytes[3] = word;
+}
+
+/* Loads a code word that was stored in big endian order */
+static inline uint32_t load_codeword(const unsigned char *bytes)
+{
+        return (uint32_t) bytes[0] << 24 | (uint32_t) bytes[1] << 16 |
+               (uint32_t) bytes[2] << 8 | (uint32_t) bytes[3];
+}
+
+/* Packs code words [first, count) one at a time */
+#define SCALAR_FIELD(name, width, lsb, sign) fields.name = row.name[i];
+static void scalar_pack_row(struct Codeword_row row, long first, long count,
+                            unsigned char *bytes)
+{
+        for (long i = first; i < count; i++) {
+                struct Codeword_fields fields;
+                CODEWORD_FIELDS(SCALAR_FIELD)
+                store_codeword(Codeword_pack(fields), bytes + 4 * i);
+        }
+}
+#undef SCALAR_FIELD
+
+/* Unpacks code words [first, count) one at a time */
+#define SCALAR_FIELD(name, width, lsb, sign) row.name[i] = fields.name;
+static void scalar_unpack_row(const unsigned char *bytes, long first,
+                              long count, struct Codeword_row row)
+{
+        for (long i = first; i < count; i++) {
+                struct Codeword_fields fields =
+                        Codeword_unpack(load_codeword(bytes + 4 * i));
+                CODEWORD_FIELDS(SCALAR_FIELD)
+        }
+}
+#undef SCALAR_FIELD
+
+#if defined(__SSE2__)
+
+/* Reverses the bytes of each 32-bit lane: swap the 16-bit halves, then the
+ * bytes within each half, since SSE2 has no byte shuffle */
+static inline __m128i sse2_bswap(__m128i word)
+{
+        word = _mm_shufflelo_epi16(word, _MM_SHUFFLE(2, 3, 0, 1));
+        word = _mm_shufflehi_epi16(word, _MM_SHUFFLE(2, 3, 0, 1));
+        return _mm_or_si128(_mm_slli_epi16(word, 8), _mm_srli_epi16(word, 8));
+}
+
+/* Each field puts its low width bits, shifted up to lsb, into the word */
+#define SSE2_PUT(name, width, lsb, sign)                                 \
+        word = _mm_or_si128(word, _mm_slli_epi32(_mm_and_si128(          \
+                _mm_loadu_si128((const __m128i *) (row.name + i)),       \
+                _mm_set1_epi32(CODEWORD_LOW(width))), lsb));
+static long sse2_pack_row(struct Codeword_row row, long count,
+                          unsigned char *bytes)
+{
+        long i;
+        for (i = 0; i + 4 <= count; i += 4) {
+                __m128i word = _mm_setzero_si128();
+                CODEWORD_FIELDS(SSE2_PUT)
+                _mm_storeu_si128((__m128i *) (bytes + 4 * i),
+                                 sse2_bswap(word));
+        }
+        return i;
+}
+#undef SSE2_PUT
+
+/* Unsigned fields shift down and mask; signed fields shift their sign bit
+ * to the top, then shift back down arithmetically */
+#define SSE2_GET_UNSIGNED(word, width, lsb)                              \
+        _mm_and_si128(_mm_srli_epi32(word, lsb),                         \
+                      _mm_set1_epi32(CODEWORD_LOW(width)))
+#define SSE2_GET_SIGNED(word, width, lsb)                                \
+        _mm_srai_epi32(_mm_slli_epi32(word, 32 - (width) - (lsb)),       \
+                       32 - (width))
+#define SSE2_GET(name, width, lsb, sign)                                 \
+        _mm_storeu_si128((__m128i *) (row.name + i),                     \
+                         SSE2_GET_##sign(word, width, lsb));
+static long sse2_unpack_row(const unsigned char *bytes, long count,
+                            struct Codeword_row row)
+{
+        long i;
+        for (i = 0; i + 4 <= count; i += 4) {
+                __m128i word = sse2_bswap(_mm_loadu_si128(
+                                (const __m128i *) (bytes + 4 * i)));
+                CODEWORD_FIELDS(SSE2_GET)
+        }
+        return i;
+}
+#undef SSE2_GET
+#undef SSE2_GET_UNSIGNED
+#undef SSE2_GET_SIGNED
+
+#endif /* __SSE2__ */
+
+#if defined(__GNUC__) && defined(__x86_64__)
+#define AVX2 __attribute__((target("avx2")))
+
+/* Reverses the bytes of each 32-bit lane with a single byte shuffle */
+AVX2 static inline __m256i avx2_bswap(__m256i word)
+{
+        const __m256i order = _mm256_setr_epi8(3, 2, 1, 0, 7, 6, 5, 4,
+                                               11, 10, 9, 8, 15, 14, 13, 12,
+                                               3, 2, 1, 0, 7, 6, 5, 4,
+                                               11, 10, 9, 8, 15, 14, 13, 12);
+        return _mm256_shuffle_epi8(word, order);
+}
+
+#define AVX2_PUT(name, width, lsb, sign)                                 \
+        word = _mm256_or_si256(word, _mm256_slli_epi32(_mm256_and_si256( \
+                _mm256_loadu_si256((const __m256i *) (row.name + i)),    \
+                _mm256_set1_epi32(CODEWORD_LOW(width))), lsb));
+AVX2 static long avx2_pack_row(struct Codeword_row row, long count,
+                               unsigned char *bytes)
+{
+        long i;
+        for (i = 0; i + 8 <= count; i += 8) {
+                __m256i word = _mm256_setzero_si256();
+                CODEWORD_FIELDS(AVX2_PUT)
+                _mm256_storeu_si256((__m256i *) (bytes + 4 * i),
+                                    avx2_bswap(word));
+        }
+        return i;
+}
+#undef AVX2_PUT
+
+#define AVX2_GET_UNSIGNED(word, width, lsb)                              \
+        _mm256_and_si256(_mm256_srli_epi32(word, lsb),                   \
+                         _mm256_set1_epi32(CODEWORD_LOW(width)))
+#define AVX2_GET_SIGNED(word, width, lsb)                                \
+        _mm256_srai_epi32(_mm256_slli_epi32(word, 32 - (width) - (lsb)), \
+                          32 - (width))
+#define AVX2_GET(name, width, lsb, sign)                                 \
+        _mm256_storeu_si256((__m256i *) (row.name + i),                  \
+                            AVX2_GET_##sign(word, width, lsb));
+AVX2 static long avx2_unpack_row(const unsigned char *bytes, long count,
+                                 struct Codeword_row row)
+{
+        long i;
+        for (i = 0; i + 8 <= count; i += 8) {
+                __m256i word = avx2_bswap(_mm256_loadu_si256(
+                                (const __m256i *) (bytes + 4 * i)));
+                CODEWORD_FIELDS(AVX2_GET)
+        }
+        return i;
+}
+#undef AVX2_GET
+#undef AVX2_GET_UNSIGNED
+#undef AVX2_GET_SIGNED
+
+#undef AVX2
+#define HAVE_AVX2_KERNELS 1
+#endif
+
+/***************************Codeword_pack_row*********************************
+*
+* Packs a row of code words into big endian bytes
+*
+* Parameters: struct Codeword_row row: the fields of each code word
+*             long count: the number of code words
+*             unsigned char *bytes: where to store the code words
+*
+* Expects: every array of row holds count values that fit their fields, and
+*          bytes has room for 4 * count bytes. count must not be negative,
+*          which is a checked runtime error.
+*
+* Return: nothing, but stores the bytes exactly as Codeword_pack would
+*
+*********************************************************************/
+void Codeword_pack_row(struct Codeword_row row, long count,
+                       unsigned char *bytes)
+{
+        assert(count >= 0);
+        long done = 0;
+#if defined(HAVE_AVX2_KERNELS)
+        if (__builtin_cpu_supports("avx2")) {
+                done = avx2_pack_row(row, count, bytes);
+        }
+#endif
+#if defined(__SSE2__)
+        if (done == 0) {
+                done = sse2_pack_row(row, count, bytes);
+        }
+#endif
+        scalar_pack_row(row, done, count, bytes);
+}
+
+/***************************Codeword_unpack_row*******************************
+*
+* Unpacks a row of big endian code words into the arrays of a Codeword_row
+*
+* Parameters: const unsigned char *bytes: 4 * count bytes of code words
+*             long count: the number of code words
+*             struct Codeword_row row: where to store the fields
+*
+* Expects: every array of row has room for count values. count must not be
+*          negative, which is a checked runtime error.
+*
+* Return: nothing, but stores the fields exactly as Codeword_unpack would
+*
+*********************************************************************/
+void Codeword_unpack_row(const unsigned char *bytes, long count,
+                         struct Codeword_row row)
+{
+        assert(count >= 0);
+        long done = 0;
+#if defined(HAVE_AVX2_KERNELS)
+        if (__builtin_cpu_supports("avx2")) {
+                done = avx2_unpack_row(bytes, count, row);
+        }
+#endif
+#if defined(__SSE2__)
+        if (done == 0) {
+                done = sse2_unpack_row(bytes, count, row);
+        }
+#endif
+        scalar_unpack_row(bytes, done, count, row);
+}
+
+#undef HAVE_AVX2_KERNELS
@@ -0,0 +1,136 @@
+/*
+ *     codeword.h
+ *     by Abhinav Mummameni (amumma01) and Rolando Ortega (rorteg02)
+ *
+ *     The layout of a 32-bit code word, declared once at compile time. Each
+ *     field of CODEWORD_FIELDS has a name, a width, the position of its
+ *     least significant bit, and a signedness, and this header generates an
+ *     inline Codeword_get_<name> and Codeword_put_<name> for it with
+ *     constant masks and shifts. Unlike the Bitpack interface, nothing is
+ *     checked at runtime: puts keep only the low width bits of their value,
+ *     so callers must make sure their values fit.
+ *
+ *     Whole rows of code words can also be packed straight into big endian
+ *     bytes, and unpacked from them, with Codeword_pack_row and 
+ *     Codeword_unpack_row, which work on several code words at a time with
+ *     SIMD shifts, masks and byte shuffles.
+ */
+
+#ifndef CODEWORD_INCLUDED
+#define CODEWORD_INCLUDED
+
+#include <stdint.h>
+
+/* X(name, width, lsb, signedness), from the most significant field down */
+#define CODEWORD_FIELDS(X)              \
+        X(a,      6, 26, UNSIGNED)      \
+        X(b,      6, 20, SIGNED)        \
+        X(c,      6, 14, SIGNED)        \
+        X(d,      6,  8, SIGNED)        \
+        X(pb_bar, 4,  4, UNSIGNED)      \
+        X(pr_bar, 4,  0, UNSIGNED)
+
+#define CODEWORD_TYPE_UNSIGNED unsigned
+#define CODEWORD_TYPE_SIGNED   int
+
+#define CODEWORD_LOW(width) (((uint32_t) 1 << (width)) - 1)
+#define CODEWORD_MASK(width, lsb) (CODEWORD_LOW(width) << (lsb))
+
+/* Sign extension without branches: flip the sign bit, then subtract it */
+#define CODEWORD_EXTEND_UNSIGNED(bits, width) (bits)
+#define CODEWORD_EXTEND_SIGNED(bits, width)                              \
+        ((int) ((bits) ^ ((uint32_t) 1 << ((width) - 1))) -             \
+         (int) ((uint32_t) 1 << ((width) - 1)))
+
+#define CODEWORD_ACCESSORS(name, width, lsb, sign)                       \
+static inline CODEWORD_TYPE_##sign Codeword_get_##name(uint32_t word)    \
+{                                                                        \
+        uint32_t bits = (word >> (lsb)) & CODEWORD_LOW(width);           \
+        return CODEWORD_EXTEND_##sign(bits, width);                      \
+}                                                                        \
+static inline uint32_t Codeword_put_##name(uint32_t word,               \
+                                           CODEWORD_TYPE_##sign value)   \
+{                                                                        \
+        return (word & ~CODEWORD_MASK(width, lsb)) |                     \
+               ((uint32_t) value & CODEWORD_LOW(width)) << (lsb);        \
+}
+
+CODEWORD_FIELDS(CODEWORD_ACCESSORS)
+
+/* struct Codeword_fields - the value of every field of a code word */
+#define CODEWORD_MEMBER(name, width, lsb, sign) CODEWORD_TYPE_##sign name;
+struct Codeword_fields {
+        CODEWORD_FIELDS(CODEWORD_MEMBER)
+};
+
+/* Packs every field into a new code word */
+#define CODEWORD_PUT(name, width, lsb, sign)                             \
+        word |= ((uint32_t) fields.name & CODEWORD_LOW(width)) << (lsb);
+static inline uint32_t Codeword_pack(struct Codeword_fields fields)
+{
+        uint32_t word = 0;
+        CODEWORD_FIELDS(CODEWORD_PUT)
+        return word;
+}
+
+/* Unpacks every field of a code word */
+#define CODEWORD_GET(name, width, lsb, sign)                             \
+        fields.name = Codeword_get_##name(word);
+static inline struct Codeword_fields Codeword_unpack(uint32_t word)
+{
+        struct Codeword_fields fields;
+        CODEWORD_FIELDS(CODEWORD_GET)
+        return fields;
+}
+
+/* Field numbers, in the order of CODEWORD_FIELDS */
+#define CODEWORD_INDEX(name, width, lsb, sign) CODEWORD_INDEX_##name,
+enum { CODEWORD_FIELDS(CODEWORD_INDEX) CODEWORD_NFIELDS };
+
+/* struct Codeword_row - the fields of a row of code words, one array per 
+ * field, so that the same field of neighboring code words is contiguous */
+#define CODEWORD_COLUMN(name, width, lsb, sign) int32_t *name;
+struct Codeword_row {
+        CODEWORD_FIELDS(CODEWORD_COLUMN)
+};
+
+/* Returns the row that starts at offset in each of the CODEWORD_NFIELDS 
+ * arrays in fields, which are stride elements apart */
+#define CODEWORD_AT(name, width, lsb, sign)                              \
+        row.name = fields + CODEWORD_INDEX_##name * stride + offset;
+static inline struct Codeword_row Codeword_row_at(int32_t *fields, 
+                                                  long stride, long offset)
+{
+        struct Codeword_row row;
+        CODEWORD_FIELDS(CODEWORD_AT)
+        return row;
+}
+
+/* Packs count code words from the fields of row into 4 * count bytes, each 
+ * code word in big endian order */
+extern void Codeword_pack_row  (struct Codeword_row row, long count, 
+                                unsigned char *bytes);
+
+/* Unpacks count big endian code words from bytes into the fields of row */
+extern void Codeword_unpack_row(const unsigned char *bytes, long count, 
+                                struct Codeword_row row);
+
+/* The fields must fill all 32 bits without overlapping, which holds exactly
+ * when their widths add up to 32 and their masks cover every bit */
+#define CODEWORD_WIDTH(name, width, lsb, sign) + (width)
+#define CODEWORD_BITS(name, width, lsb, sign) | CODEWORD_MASK(width, lsb)
+typedef char Codeword_layout_is_valid[
+        (0 CODEWORD_FIELDS(CODEWORD_WIDTH)) == 32 &&
+        (0 CODEWORD_FIELDS(CODEWORD_BITS)) == 0xffffffff ? 1 : -1];
+
+#undef CODEWORD_INDEX
+#undef CODEWORD_COLUMN
+#undef CODEWORD_AT
+#undef CODEWORD_ACCESSORS
+#undef CODEWORD_MEMBER
+#undef CODEWORD_PUT
+#undef CODEWORD_GET
+#undef CODEWORD_WIDTH
+#undef CODEWORD_BITS
+
+#endif
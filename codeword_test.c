@@ -0,0 +1,118 @@
+/*
+ *     codeword_test.c
+ *     by Abhinav Mummameni (amumma01) and Rolando Ortega (rorteg02)
+ *
+ *     Test program, built and run by 'make test', for the codeword
+ *     interface. Checks that unpacking and repacking every 9973rd 32-bit
+ *     code word gives it back, and that Codeword_pack_row and
+ *     Codeword_unpack_row, whose SIMD kernels handle several code words at a
+ *     time, give exactly the bytes and fields of the scalar Codeword_pack and
+ *     Codeword_unpack for random rows of every length up to 99, at every
+ *     byte alignment.
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+#include "codeword.h"
+#include "testutil.h"
+
+#define MAX_COUNT 99
+#define STEP 9973
+
+/* The big endian bytes of a code word */
+static void store_word(uint32_t word, unsigned char *bytes)
+{
+        bytes[0] = word >> 24;
+        bytes[1] = word >> 16;
+        bytes[2] = word >> 8;
+        bytes[3] = word;
+}
+
+/* Unpacks and repacks every STEP-th code word. Returns the number of
+ * failures. */
+static int check_words(void)
+{
+        int failures = 0;
+        for (uint64_t word = 0; word <= UINT32_MAX; word += STEP) {
+                uint32_t repacked = Codeword_pack(Codeword_unpack(word));
+                if (repacked != word) {
+                        fprintf(stderr, "FAIL: 0x%08x repacks to 0x%08x\n",
+                                (unsigned) word, (unsigned) repacked);
+                        failures++;
+                }
+        }
+        return failures;
+}
+
+/* Loads the code word stored at bytes in big endian order */
+static uint32_t load_word(const unsigned char *bytes)
+{
+        return (uint32_t) bytes[0] << 24 | (uint32_t) bytes[1] << 16 |
+               (uint32_t) bytes[2] << 8 | (uint32_t) bytes[3];
+}
+
+#define FIELD_STORE(name, width, lsb, sign) row.name[i] = fields.name;
+#define FIELD_DIFFERS(name, width, lsb, sign) \
+        || row.name[i] != (int32_t) fields.name
+
+/* Packs and unpacks a random row of count code words that starts offset
+ * bytes into its buffer. Returns the number of failures. */
+static int check_row(long count, int offset)
+{
+        int32_t storage[CODEWORD_NFIELDS * MAX_COUNT];
+        unsigned char buffer[4 * MAX_COUNT + 4];
+        unsigned char expected[4 * MAX_COUNT];
+        unsigned char *bytes = buffer + offset;
+        struct Codeword_row row = Codeword_row_at(storage, MAX_COUNT, 0);
+        int failures = 0;
+
+        /* Random words give random fields that are known to fit */
+        for (long i = 0; i < count; i++) {
+                uint32_t word = Testutil_random();
+                struct Codeword_fields fields = Codeword_unpack(word);
+                CODEWORD_FIELDS(FIELD_STORE)
+                store_word(word, expected + 4 * i);
+        }
+
+        memset(buffer, 0xa5, sizeof(buffer));
+        Codeword_pack_row(row, count, bytes);
+        if (memcmp(bytes, expected, 4 * count) != 0 ||
+            bytes[4 * count] != 0xa5) {
+                fprintf(stderr, "FAIL: pack_row of %ld code words at offset "
+                        "%d\n", count, offset);
+                failures++;
+        }
+
+        memset(storage, 0x5a, sizeof(storage));
+        memcpy(bytes, expected, 4 * count);
+        Codeword_unpack_row(bytes, count, row);
+        for (long i = 0; i < count; i++) {
+                struct Codeword_fields fields = 
+                        Codeword_unpack(load_word(expected + 4 * i));
+                if (0 CODEWORD_FIELDS(FIELD_DIFFERS)) {
+                        fprintf(stderr, "FAIL: unpack_row of %ld code words "
+                                "at offset %d, word %ld\n", count, offset, 
+                                i);
+                        failures++;
+                        break;
+                }
+        }
+        return failures;
+}
+
+#undef FIELD_STORE
+#undef FIELD_DIFFERS
+
+int main(void)
+{
+        int failures = check_words();
+        for (long count = 0; count <= MAX_COUNT; count++) {
+                for (int offset = 0; offset < 4; offset++) {
+                        failures += check_row(count, offset);
+                }
+        }
+        printf("codeword: %d failures\n", failures);
+        return failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -12,32 +12,267 @@
 #include <assert.h>
 #include <except.h>
 #include <math.h>
+#include <string.h>
+#include <limits.h>
 #include "compress40.h"
 #include "pnm.h"
-#include "a2methods.h"
-#include "a2plain.h"
-#include "arith40.h"
-#include "bitpack.h"
+#include "codeword.h"
+#include "fixed.h"
 #include "conversion.h"
+#include "parallel.h"
+#include "outbuf.h"
+#include "mapped.h"
+#include "ppmstream.h"
+#include "stats.h"
+#include "tiles.h"
+#include "runs.h"
+#include "blockdct.h"
+#include "texcept.h"
 
-#define A2 A2Methods_UArray2
-typedef void (*MapFunc) (A2 arr, A2Methods_T methods, unsigned denominator, 
-                        int col, int row, void *cl);
+/* Block rows per thread in each window of a compressed stream */
+#define STRIP_ROWS 32
+/* Tile size in pixels of entropy coded images, unless one is given */
+#define DEFAULT_TILE_SIZE 256
 /****************** Helper functions and exceptions *******************/
-void map_2by2(A2 arr, A2Methods_T methods, unsigned denominator, MapFunc func, 
-                void *cl);
-void encode_2by2(A2 arr, A2Methods_T methods, unsigned denominator, int col, 
-                                int row, void *cl);
-void pack_block(Compressed compressed);
-int scale_DCT(double coefficient);
-uint64_t make_codeword(unsigned pb_bar, unsigned pr_bar, unsigned int a, int b,
-                        int c, int d);
-Compressed decode_codeword(uint64_t codeword);
-void decode_2by2(A2 arr, A2Methods_T methods, unsigned denominator, int col, 
-                                int row, void *cl);
-double unscale_DCT(int scaled);
+struct Window;
+struct Strips;
+int read_header(FILE *input, unsigned *width, unsigned *height, 
+                Tiles_T *tiles, unsigned *block_size);
+void compress_stream(Ppmstream_T source, Outbuf_T out, Tiles_T tiles,
+                     Blockdct_T codec);
+void encode_windows(Ppmstream_T source, struct Window *window, int rows, 
+                    int window_rows);
+void free_window(struct Window *window);
+void encode_strip(int first, int last, void *cl);
+void write_strip(int first, int last, void *cl);
+void decompress_stream(FILE *input, unsigned width, unsigned height, 
+                       Blockdct_T codec, Outbuf_T out);
+void decompress_runs(FILE *input, unsigned width, unsigned height, 
+                     Outbuf_T out);
+void decompress_region(FILE *input, unsigned width, unsigned height, 
+                       Tiles_T tiles, int runs, int thumbnail, unsigned x, 
+                       unsigned y, unsigned w, unsigned h, Outbuf_T out);
+const unsigned char *next_coded_row(FILE *input, Mapped_T payload, 
+                                    long *offset, unsigned char *buffer, 
+                                    int count);
+void gather_row(Tiles_T tiles, const unsigned char *bytes, 
+                const unsigned char *coded, int count, int row, 
+                int first_col, int last_col, unsigned char *to);
+void free_strips(struct Strips *strips);
+void decode_strip(int first, int last, void *cl);
+void write_raster(int first, int last, void *cl);
+void write_region(int first, int last, void *cl);
+void write_blank_rows(Outbuf_T out, long row_bytes, unsigned rows);
+long output_capacity(unsigned rows, unsigned width);
 
 Except_T SHORT_FILE = { "Supplied file is too short" };
+Except_T BAD_HEADER = { "Compressed image header is malformed" };
+Except_T BAD_REGION = { "Region is empty or not inside the image" };
+Except_T NO_REGIONS = { "Format 6 images have no regions or thumbnails" };
+
+static unsigned num_threads = 1;
+static int fixed_point = 0;
+static unsigned tile_size = 0;
+static int entropy_coded = 0;
+static int run_length = 0;
+static unsigned block_size = 2;
+
+/* struct Window - Closure for compressing a window of block rows on one or 
+ * more threads. pixels holds the two pixel rows of each block row in the 
+ * window, each width pixels long. blocks and fields have room for the count
+ * blocks of each block row (fields holds CODEWORD_NFIELDS arrays of size
+ * blocks apart), bytes has room for their code words, and out is where the
+ * code words go. fixed is NULL unless the fixed-point compressor is used, 
+ * and tiles is NULL unless the code words go in tiles (format 3). If the 
+ * code words are run-length coded (format 5), each block row is coded into
+ * max_length bytes of runs, and its coded length goes in lengths; otherwise
+ * runs is NULL. If codec is not NULL, the blocks are codec's larger ones 
+ * (format 6): pixels holds all of their rows, which codec encodes straight
+ * into bytes, and blocks and fields are not used. */
+struct Window {
+        struct Pnm_rgb *pixels;
+        int width;
+        int count;
+        unsigned denominator;
+        Fixed_T fixed;
+        Compressed *blocks;
+        int32_t *fields;
+        long size;
+        unsigned char *bytes;
+        Outbuf_T out;
+        Tiles_T tiles;
+        unsigned char *runs;
+        long *lengths;
+        long max_length;
+        Blockdct_T codec;
+};
+
+/* struct Strips - Closure for decompressing a window of block rows on one or
+ * more threads. payload holds the big-endian code words for the window, in 
+ * row-major order, which are unpacked into fields (laid out as in struct 
+ * Window) and blocks. Each block row is decoded into its two pixel rows, 
+ * each width pixels long, and packed into 2 * row_bytes bytes of raster, 
+ * which is then written to out. If fixed is not NULL, the fixed-point 
+ * decoder writes the raster straight from the fields instead. 
+ * 
+ * If rows is not NULL, the code words are run-length coded (format 5), and
+ * rows holds the start of each coded block row of the window instead of 
+ * payload. Each row is split into its runs, with one code word each in 
+ * distinct and the number of blocks in runs; only one block of each run is
+ * decoded, into the compact raster, and its pixels are then copied across 
+ * the raster. 
+ *
+ * If thumbnail is nonzero, each block is decoded into just one pixel, from
+ * its a, pb_bar and pr_bar fields alone, and each block row into the first
+ * of its two rows of the raster.
+ *
+ * If codec is not NULL, the code words are codec's (format 6), and each is
+ * decoded straight into the raster rows of its block; fields, blocks and 
+ * pixels are not used. */
+struct Strips {
+        const unsigned char *payload;
+        int width;
+        int count;
+        unsigned denominator;
+        Fixed_T fixed;
+        int32_t *fields;
+        long size;
+        Compressed *blocks;
+        struct Pnm_rgb *pixels;
+        unsigned char *raster;
+        long row_bytes;
+        Outbuf_T out;
+        const unsigned char **rows;
+        unsigned char *distinct;
+        int *runs;
+        unsigned char *compact;
+        int thumbnail;
+        Blockdct_T codec;
+};
+
+/* struct Region - Closure for decompressing part of an image. The strips 
+ * cover the block columns holding the pixel columns [x, x + w), with a 
+ * last odd column (which has no blocks) left black. Of the pixel rows of 
+ * each block row (two, or one for a thumbnail), only those in [y, y + h) 
+ * are written, as out_bytes bytes starting crop bytes into the raster row.
+ * done is the block row that the current window starts at. strips comes 
+ * first, so decode_strip can be given a Region. */
+struct Region {
+        struct Strips strips;
+        unsigned y, h;
+        long crop;
+        long out_bytes;
+        int done;
+};
+
+/***************************compress40_set_threads****************************
+*
+* Sets the number of threads compress40 and decompress40 should use
+*
+* Parameters: unsigned nthreads: the number of threads to use
+*
+* Expects: nthreads is not 0, which is a checked runtime error
+*
+* Return: nothing
+*
+*********************************************************************/
+void compress40_set_threads(unsigned nthreads)
+{
+        assert(nthreads > 0);
+        num_threads = nthreads;
+}
+
+/***************************compress40_set_fixed_point************************
+*
+* Chooses between the fixed-point codec and the floating point one, for both 
+* compression and decompression
+*
+* Parameters: int enabled: nonzero to use the fixed-point codec
+*
+* Return: nothing
+*
+*********************************************************************/
+void compress40_set_fixed_point(int enabled)
+{
+        fixed_point = enabled;
+}
+
+/***************************compress40_set_entropy_coding********************
+*
+* Chooses whether compress40 entropy codes its code words
+*
+* Parameters: int enabled: nonzero to write entropy coded images (format 4)
+*
+* Return: nothing
+*
+* Notes: Entropy coded images are always tiled, with the tile size of 
+*        compress40_set_tile_size, or DEFAULT_TILE_SIZE if that is 0. The 
+*        code words, and so the decompressed pixels, are exactly the same.
+*********************************************************************/
+void compress40_set_entropy_coding(int enabled)
+{
+        entropy_coded = enabled;
+}
+
+/***************************compress40_set_run_length************************
+*
+* Chooses whether compress40 run-length codes its code words
+*
+* Parameters: int enabled: nonzero to write run-length coded images (format 
+*                          5)
+*
+* Return: nothing
+*
+* Notes: Run-length coded images are never tiled, so compress40_to makes it
+*        a checked runtime error to enable tiles or entropy coding as well.
+*        The code words are exactly the same.
+*********************************************************************/
+void compress40_set_run_length(int enabled)
+{
+        run_length = enabled;
+}
+
+/***************************compress40_set_tile_size**************************
+*
+* Chooses between tiled compressed images (format 3) and plain ones (format 
+* 2)
+*
+* Parameters: unsigned pixels: the width and height of each tile, or 0 for
+*                              plain images, the default
+*
+* Expects: pixels is even, which is a checked runtime error
+*
+* Return: nothing
+*
+*********************************************************************/
+void compress40_set_tile_size(unsigned pixels)
+{
+        assert(pixels % 2 == 0);
+        tile_size = pixels;
+}
+
+/***************************compress40_set_block_size*************************
+*
+* Chooses the size of the blocks compress40 encodes
+*
+* Parameters: unsigned pixels: the width and height of each block: 2 for the
+*                              usual code words (the default), or 4 or 8 
+*                              for format 6
+*
+* Expects: pixels is 2, 4 or 8, which is a checked runtime error
+*
+* Return: nothing
+*
+* Notes: Format 6 has no tiles, entropy coding or run-length coding, and
+*        only the floating point kernels of the Blockdct interface, so 
+*        compress40_to makes it a checked runtime error to enable any of
+*        them, or compress40_set_fixed_point, along with larger blocks.
+*********************************************************************/
+void compress40_set_block_size(unsigned pixels)
+{
+        assert(pixels == 2 || pixels == 4 || pixels == 8);
+        block_size = pixels;
+}
 
 /***************************compress40**********************************
 *
@@ -51,25 +286,109 @@ Except_T SHORT_FILE = { "Supplied file is too short" };
 *
 * Return: nothing
 *
-* Notes: Relies on the pnm.h interface to read in the contents of the file and
-*        the map_2by_2 function to compress images. Is called on by the main
-*        function in 40image to handle compression
+* Notes: Relies on the ppmstream.h interface to read the header of the file 
+*        and the compress_stream function to compress the image a window of
+*        rows at a time, so the whole image is never held in memory. Is 
+*        called on by the main function in 40image to handle compression
 *********************************************************************/
 void compress40(FILE *input)
 {
-        /* Build Pnm_ppm and handle odd-numbered dimensions*/
-        A2Methods_T methods = uarray2_methods_plain;
-        Pnm_ppm source = Pnm_ppmread(input, methods);
-        int trimmed_width = source->width - source->width % 2;
-        int trimmed_height = source->height - source->height % 2; 
+        compress40_to(input, stdout);
+}
+
+/***************************compress40_to**********************************
+*
+* Compresses the image in one file into another
+*
+* Parameters: FILE *input: a PPM image
+*             FILE *output: where to write the compressed image
+*
+* Expects: input and output are not NULL, run-length coding is not enabled
+*          along with tiles or entropy coding, and blocks larger than 2 are
+*          not combined with any of them or the fixed-point codec, which are
+*          checked runtime errors
+*
+* Return: nothing
+*
+* Notes: Uses no state but the settings of the compress40_set functions, so
+*        several images can be compressed at once on different threads, as
+*        long as the settings stay the same. If the image is bad, everything
+*        is freed before its exception is raised again with TRERAISE.
+*********************************************************************/
+void compress40_to(FILE *input, FILE *output)
+{
+        assert(input != NULL && output != NULL);
+        assert(!run_length || (tile_size == 0 && !entropy_coded));
+        assert(block_size == 2 || (!fixed_point && tile_size == 0 &&
+                                   !entropy_coded && !run_length));
+        /* Read the header and handle odd-numbered dimensions*/
+        struct Stats_mark mark = Stats_start();
+        Ppmstream_T source = Ppmstream_open(input);
+        unsigned width = Ppmstream_width(source);
+        unsigned height = Ppmstream_height(source);
+        unsigned side = block_size;
+        unsigned trimmed_width = width - width % side;
+        unsigned trimmed_height = height - height % side; 
+        Stats_count((long) width * height, 
+                    (long) (width / side) * (height / side));
+        Stats_lap(STATS_INPUT, &mark);
 
         /* Print the compressed file header and compress the given file */
-        printf("COMP40 Compressed image format 2\n%u %u\n", trimmed_width, 
-                trimmed_height);
-        map_2by2(source->pixels, methods, source->denominator, encode_2by2, 
-                        NULL);
+        Tiles_T tiles = NULL;
+        Blockdct_T codec = NULL;
+        if (side != 2) {
+                fprintf(output, "COMP40 Compressed image format 6\n"
+                        "%u %u %u\n", trimmed_width, trimmed_height, side);
+                codec = Blockdct_new(side, Ppmstream_denominator(source));
+        } else if (entropy_coded) {
+                unsigned size = tile_size != 0 ? tile_size : 
+                                                 DEFAULT_TILE_SIZE;
+                fprintf(output, "COMP40 Compressed image format 4\n"
+                        "%u %u %u\n", trimmed_width, trimmed_height, size);
+                tiles = Tiles_new(trimmed_width, trimmed_height, size, 1);
+        } else if (tile_size != 0) {
+                fprintf(output, "COMP40 Compressed image format 3\n"
+                        "%u %u %u\n", trimmed_width, trimmed_height, 
+                        tile_size);
+                tiles = Tiles_new(trimmed_width, trimmed_height, tile_size,
+                                  0);
+        } else if (run_length) {
+                fprintf(output, "COMP40 Compressed image format 5\n%u %u\n",
+                        trimmed_width, trimmed_height);
+        } else {
+                fprintf(output, "COMP40 Compressed image format 2\n%u %u\n",
+                        trimmed_width, trimmed_height);
+        }
+        Outbuf_T out = Outbuf_new(output, 0);
+        if (tiles != NULL) {
+                Tiles_begin(tiles, out);
+        }
+        Stats_lap(STATS_OUTPUT, &mark);
+        TTRY
+                compress_stream(source, out, tiles, codec);
+        TELSE
+                if (tiles != NULL) {
+                        Tiles_free(&tiles);
+                }
+                if (codec != NULL) {
+                        Blockdct_free(&codec);
+                }
+                Outbuf_free(&out);
+                Ppmstream_close(&source);
+                TRERAISE;
+        TEND_TRY;
+        mark = Stats_start();
+        if (tiles != NULL) {
+                Tiles_end(tiles, out);
+                Tiles_free(&tiles);
+        }
+        if (codec != NULL) {
+                Blockdct_free(&codec);
+        }
+        Outbuf_free(&out);
+        Stats_lap(STATS_OUTPUT, &mark);
 
-        Pnm_ppmfree(&source);
+        Ppmstream_close(&source);
 }
 
 /******************************decompress40**********************************
@@ -83,309 +402,1106 @@ void compress40(FILE *input)
 *
 * Return: nothing
 *
-* Notes: Calls on decode_2by2 to decompress the image and relies on the pnm.h
-*        interface to write the decompressed file to standard output
+* Notes: Writes the PPM header straight away, then calls on decompress_stream
+*        to decode the image a window of block rows at a time and write each
+*        row as soon as it is decoded, so the whole image is never in memory
 *********************************************************************/
 void decompress40(FILE *input)
 {
+        decompress40_to(input, stdout);
+}
+
+/***************************decompress40_to********************************
+*
+* Decompresses the image in one file into another
+*
+* Parameters: FILE *input: a compressed image
+*             FILE *output: where to write the PPM image
+*
+* Expects: input and output are not NULL, which is a checked runtime error
+*
+* Return: nothing
+*
+* Notes: Like compress40_to, may run on several threads at once, and frees
+*        everything before it raises an exception again. Reads plain (format
+*        2), tiled (format 3), entropy coded (format 4), run-length coded 
+*        (format 5) and larger block (format 6) images.
+*********************************************************************/
+void decompress40_to(FILE *input, FILE *output)
+{
+        assert(input != NULL && output != NULL);
         /* Read in the file header */
+        struct Stats_mark mark = Stats_start();
         unsigned height, width;
-        int read = fscanf(input, "COMP40 Compressed image format 2\n%u %u", 
-                                &width, &height);
-        assert(read == 2);
-        int c = getc(input);
-        assert(c == '\n');
-
-        /* Decode the image and store in UArray2 */
-        A2Methods_T methods = uarray2_methods_plain;
-        A2 decompressed = methods->new(width, height, sizeof(struct Pnm_rgb));
-        assert(decompressed != NULL);
-        map_2by2(decompressed, methods, 255, decode_2by2, input);
-
-        /* Create new Pnm_ppm & write decompressed image to standard output */
-        Pnm_ppm output;
-        NEW(output);
-        output->denominator = 255;
-        output->width = width;
-        output->height = height;
-        output->pixels = decompressed;
-        output->methods = methods;
-
-        Pnm_ppmwrite(stdout, output);
-        Pnm_ppmfree(&output);
+        Tiles_T tiles = NULL;
+        unsigned side;
+        int version = read_header(input, &width, &height, &tiles, &side);
+        Stats_count((long) width * height, 
+                    (long) (width / side) * (height / side));
+        Stats_lap(STATS_INPUT, &mark);
+
+        /* Write the PPM header, then the rows as they are decoded */
+        Ppmstream_write_header(output, width, height, 255);
+        Outbuf_T out = Outbuf_new(output, output_capacity(side, width));
+        Blockdct_T codec = version == 6 ? Blockdct_new(side, 255) : NULL;
+        Stats_lap(STATS_OUTPUT, &mark);
+        TTRY
+                if (tiles != NULL) {
+                        decompress_region(input, width, height, tiles, 0, 0,
+                                          0, 0, width, height, out);
+                } else if (version == 5) {
+                        decompress_runs(input, width, height, out);
+                } else {
+                        decompress_stream(input, width, height, codec, out);
+                }
+        TELSE
+                if (tiles != NULL) {
+                        Tiles_free(&tiles);
+                }
+                if (codec != NULL) {
+                        Blockdct_free(&codec);
+                }
+                Outbuf_free(&out);
+                TRERAISE;
+        TEND_TRY;
+        mark = Stats_start();
+        if (tiles != NULL) {
+                Tiles_free(&tiles);
+        }
+        if (codec != NULL) {
+                Blockdct_free(&codec);
+        }
+        Outbuf_free(&out);
+        Stats_lap(STATS_OUTPUT, &mark);
 }
 
-/*****************************map_2by2**********************************
+/***************************decompress40_region****************************
 *
-* Function that maps each two by two pixel block and either compressed or 
-* decompresses, depending on the passed in apply function
+* Decompresses one rectangle of an image into a PPM image of its own
 *
-* Parameters: A2 arr: a UArray2 that contains all of the pixels from the input
-*                     file
-*             A2Methods_T methods: a methods suite for the UArray2
-*             unsigned denominator: the denominator for the rgb values of each
-*                     pixel, for calculating decompression
-*             MapFunc func: an apply function
-*             void *cl: a closure for the mapping function 
+* Parameters: FILE *input: a compressed image, in any format but 6
+*             FILE *output: where to write the PPM image of the rectangle
+*             unsigned x, y: the column and row of the rectangle's top left
+*                            pixel
+*             unsigned w, h: the width and height of the rectangle
 *
-* Expects: Expects that arr is not NULL and will throw a checked runtime error
-*                   if it is. 
+* Expects: input and output are not NULL, which is a checked runtime error
 *
-* Return: nothing, but will map the array and call the given functionfor
-*         either compression or decompression
+* Return: nothing
 *
-* Notes: Apply functions for this function will either by encode_2by2 or 
-*        decode_2by2
+* Notes: Only the code words of the blocks that cover the rectangle are 
+*        decoded. Regular files are memory mapped, so with a tiled image 
+*        only the tiles that hold those blocks are ever read from disk.
+*        The pixels are exactly those decompress40 writes for the same spot.
+*        Raises NO_REGIONS for a format 6 image, and BAD_REGION if the 
+*        rectangle is empty or does not lie inside the image, before 
+*        anything is written.
 *********************************************************************/
-void map_2by2(A2 arr, A2Methods_T methods, unsigned denominator, MapFunc func, 
-                void *cl)
+void decompress40_region(FILE *input, FILE *output, unsigned x, unsigned y,
+                         unsigned w, unsigned h)
 {
-        /* Check array is not NULL */
-        assert(arr != NULL);
-        int width = methods->width(arr);
-        int height = methods->height(arr);
+        assert(input != NULL && output != NULL);
+        struct Stats_mark mark = Stats_start();
+        unsigned height, width;
+        Tiles_T tiles = NULL;
+        unsigned side;
+        int version = read_header(input, &width, &height, &tiles, &side);
+        if (version == 6) {
+                TRAISE(NO_REGIONS);
+        }
+        if (w == 0 || h == 0 || x >= width || y >= height || 
+            w > width - x || h > height - y) {
+                if (tiles != NULL) {
+                        Tiles_free(&tiles);
+                }
+                TRAISE(BAD_REGION);
+        }
+        Stats_count((long) w * h, (long) ((w + 1) / 2) * ((h + 1) / 2));
+        Stats_lap(STATS_INPUT, &mark);
 
-        /* Map through each 2x2 block in the array in row-major order */
-        for (int row = 0; row < height - 1; row += 2) {
-                for (int col = 0; col < width - 1; col += 2 ) {
-                        func(arr, methods, denominator, col, row, cl);
+        Ppmstream_write_header(output, w, h, 255);
+        Outbuf_T out = Outbuf_new(output, output_capacity(2, w));
+        Stats_lap(STATS_OUTPUT, &mark);
+        TTRY
+                decompress_region(input, width, height, tiles, version == 5,
+                                  0, x, y, w, h, out);
+        TELSE
+                Outbuf_free(&out);
+                if (tiles != NULL) {
+                        Tiles_free(&tiles);
                 }
+                TRERAISE;
+        TEND_TRY;
+        mark = Stats_start();
+        Outbuf_free(&out);
+        if (tiles != NULL) {
+                Tiles_free(&tiles);
         }
+        Stats_lap(STATS_OUTPUT, &mark);
 }
 
-/*****************************encode_2by2**********************************
+/***************************decompress40_thumbnail**************************
 *
-* Function that compressed and packs the block for the pixel at the given row
-* and column 
+* Decompresses a half-size thumbnail of an image, with one pixel per block
 *
-* Parameters: A2 arr: a UArray2 that contains all of the pixels from the input
-*                     file
-*             A2Methods_T methods: a methods suite for the UArray2
-*             unsigned denominator: the denominator for the rgb values of each
-                      pixel, for calculating decompression
-              int col: a column in the array
-              int row: a row in the array
+* Parameters: FILE *input: a compressed image, in any format but 6
+*             FILE *output: where to write the PPM image of the thumbnail
 *
-* Expects: Expects that arr is not NULL and will throw a checked runtime error
-*                   if it is. 
+* Expects: input and output are not NULL, which is a checked runtime error
 *
-* Return: nothing, but will result in a compressed image
+* Return: nothing
 *
-* Notes: relies on the getCompressed function in the conversion.h interface to
-*                   create a compressed block of pixels. Calls on pack_block to
-*                   pack the values in the block and print them. Used as an 
-*                   apply function for map_2by2 when undergoing compression
+* Notes: The a, pb_bar and pr_bar fields of a code word are the average 
+*        luma and chroma of its block, so each pixel of the thumbnail comes 
+*        from just those three, with no inverse DCT. The b, c and d fields 
+*        are never used. The code words are read just as decompress40_region
+*        reads them for the whole image. Raises NO_REGIONS for a format 6 
+*        image.
 *********************************************************************/
-void encode_2by2(A2 arr, A2Methods_T methods, unsigned denominator, int col, 
-                                int row, void *cl)
+void decompress40_thumbnail(FILE *input, FILE *output)
 {
-        /* Check array is not NULL */
-        (void) cl;
-        assert(arr != NULL);
-        Compressed compressed = getCompressed(arr, methods, col, row, 
-                        denominator);
-        pack_block(compressed);
+        assert(input != NULL && output != NULL);
+        struct Stats_mark mark = Stats_start();
+        unsigned height, width;
+        Tiles_T tiles = NULL;
+        unsigned side;
+        int version = read_header(input, &width, &height, &tiles, &side);
+        if (version == 6) {
+                TRAISE(NO_REGIONS);
+        }
+        unsigned count = width / 2;
+        unsigned rows = height / 2;
+        Stats_count((long) count * rows, (long) count * rows);
+        Stats_lap(STATS_INPUT, &mark);
+
+        Ppmstream_write_header(output, count, rows, 255);
+        Outbuf_T out = Outbuf_new(output, output_capacity(1, count));
+        Stats_lap(STATS_OUTPUT, &mark);
+        TTRY
+                if (count > 0 && rows > 0) {
+                        decompress_region(input, width, height, tiles, 
+                                          version == 5, 1, 0, 0, count, 
+                                          rows, out);
+                }
+        TELSE
+                Outbuf_free(&out);
+                if (tiles != NULL) {
+                        Tiles_free(&tiles);
+                }
+                TRERAISE;
+        TEND_TRY;
+        mark = Stats_start();
+        Outbuf_free(&out);
+        if (tiles != NULL) {
+                Tiles_free(&tiles);
+        }
+        Stats_lap(STATS_OUTPUT, &mark);
 }
 
-/*****************************pack_block**********************************
+/*****************************read_header**********************************
+*
+* Reads the header of a compressed image
+*
+* Parameters: FILE *input: a compressed image
+*             unsigned *width, *height: where to store the size of the image
+*             Tiles_T *tiles: where to store the layout of the tiles of a 
+*                             tiled image, or NULL for a plain one
+*             unsigned *block_size: where to store the width and height of
+*                                   each block in pixels
 *
-* Creates the code word for the given pixel block and prints the code out
+* Return: the version of the format, 2 (plain), 3 (tiled), 4 (tiled and
+*         entropy coded), 5 (run-length coded) or 6 (blocks of 4 or 8 
+*         pixels), with input positioned at the first code word or tile
 *
-* Parameters: Compressed compressed: a 2x2 block of pixels 
+* Notes: Raises BAD_HEADER if the header is not well formed. The tile index 
+*        of a tiled image is read and checked with the Tiles interface, 
+*        which raises Tiles_Badindex if it is corrupt; the tiles are freed
+*        first.
+*********************************************************************/
+int read_header(FILE *input, unsigned *width, unsigned *height, 
+                Tiles_T *tiles, unsigned *block_size)
+{
+        unsigned version;
+        unsigned size = 0;
+        *tiles = NULL;
+        *block_size = 2;
+        int read = fscanf(input, "COMP40 Compressed image format %u\n%u %u",
+                                &version, width, height);
+        if (read != 3 || version < 2 || version > 6) {
+                TRAISE(BAD_HEADER);
+        }
+        if (version == 6) {
+                read = fscanf(input, "%u", block_size);
+                if (read != 1 || (*block_size != 4 && *block_size != 8)) {
+                        TRAISE(BAD_HEADER);
+                }
+        }
+        if (version == 3 || version == 4) {
+                read = fscanf(input, "%u", &size);
+                if (read != 1 || size < 2 || size % 2 != 0) {
+                        TRAISE(BAD_HEADER);
+                }
+        }
+        if (getc(input) != '\n') {
+                TRAISE(BAD_HEADER);
+        }
+        if (size != 0) {
+                Tiles_T layout = Tiles_new(*width, *height, size, 
+                                           version == 4);
+                TTRY
+                        Tiles_read_index(layout, input);
+                TELSE
+                        Tiles_free(&layout);
+                        TRERAISE;
+                TEND_TRY;
+                *tiles = layout;
+        }
+        return version;
+}
+
+/*****************************compress_stream********************************
 *
-* Expects: None
+* Compresses the rows of an image as they are read, a window of block rows at
+* a time
 *
-* Return: nothing, but prints code word to standard output 
+* Parameters: Ppmstream_T source: an image whose header has been read
+*             Outbuf_T out: where to write the code words
+*             Tiles_T tiles: the layout of the tiles, or NULL
+*             Blockdct_T codec: the codec of larger blocks (format 6), or 
+*                               NULL for 2 by 2 ones
 *
-* Notes: relies on the Arith40 interface to create the indices for the chroma, 
-*        and the scale_DCT and make_codeword functons to scale the DCT 
-*        coefficients and make the code word, respectively.
+* Expects: source and out are not NULL
+*
+* Return: nothing, but writes the code word of every block to out
+*
+* Notes: With one thread, the window is a single block row, so exactly two 
+*        pixel rows are held in memory at a time. With more, each window holds
+*        STRIP_ROWS block rows per thread, and Parallel_for splits it into one
+*        horizontal strip per thread. encode_strip encodes each strip and 
+*        write_strip writes the strips in order, so the output is 
+*        byte-for-byte the same no matter how many threads are used. Either 
+*        way, memory use depends on the width of the image, not its height.
+*        If tiles is not NULL, the code words go through Tiles_write_row, 
+*        which holds at most one row of tiles. Otherwise, if run-length 
+*        coding is on, encode_strip codes each block row into runs. With a
+*        codec, each block row holds all of the pixel rows of its blocks.
+*        The window is freed before Pnm_Badformat, raised if the image ends
+*        early or holds a bad sample, goes on to the caller.
+*********************************************************************/
+void compress_stream(Ppmstream_T source, Outbuf_T out, Tiles_T tiles,
+                     Blockdct_T codec)
+{
+        int side = codec != NULL ? (int) Blockdct_size(codec) : 2;
+        int word_bytes = codec != NULL ? Blockdct_bytes(codec) : 4;
+        int width = Ppmstream_width(source);
+        int count = width / side;
+        int rows = Ppmstream_height(source) / side;
+        if (count == 0 || rows == 0) {
+                return;
+        }
+        int window_rows = num_threads == 1 ? 1 : num_threads * STRIP_ROWS;
+        if (window_rows > rows) {
+                window_rows = rows;
+        }
+
+        unsigned denominator = Ppmstream_denominator(source);
+        struct Window window = { NULL, width, count, denominator, NULL, NULL,
+                                 NULL, (long) window_rows * count, NULL, out,
+                                 tiles, NULL, NULL, 0, codec };
+        window.pixels = ALLOC((long) side * window_rows * width * 
+                              sizeof(*window.pixels));
+        if (codec == NULL) {
+                if (fixed_point) {
+                        window.fixed = Fixed_new(denominator);
+                }
+                window.blocks = ALLOC(window.size * sizeof(*window.blocks));
+                window.fields = ALLOC(CODEWORD_NFIELDS * window.size * 
+                                      sizeof(*window.fields));
+        }
+        window.bytes = ALLOC(word_bytes * window.size);
+        if (run_length && tiles == NULL) {
+                window.max_length = Runs_max_length(count);
+                window.runs = ALLOC(window_rows * window.max_length);
+                window.lengths = ALLOC(window_rows * sizeof(*window.lengths));
+        }
+        TTRY
+                encode_windows(source, &window, rows, window_rows);
+        TFINALLY
+                free_window(&window);
+        TEND_TRY;
+}
+
+/*****************************encode_windows********************************
+*
+* Reads the rows block rows of an image a window of window_rows block rows
+* at a time, and compresses each window, for compress_stream
+*
+*********************************************************************/
+void encode_windows(Ppmstream_T source, struct Window *window, int rows, 
+                    int window_rows)
+{
+        int side = window->codec != NULL ? (int) Blockdct_size(window->codec)
+                                         : 2;
+        for (int done = 0; done < rows; done += window_rows) {
+                if (window_rows > rows - done) {
+                        window_rows = rows - done;
+                }
+                struct Stats_mark mark = Stats_start();
+                for (int row = 0; row < side * window_rows; row++) {
+                        Ppmstream_read_row(source, window->pixels + 
+                                           (long) row * window->width);
+                }
+                Stats_lap(STATS_INPUT, &mark);
+                Parallel_for(num_threads, window_rows, encode_strip, 
+                             write_strip, window);
+        }
+}
+
+/*****************************free_window***********************************
+*
+* Frees the buffers of a window
+*
+*********************************************************************/
+void free_window(struct Window *window)
+{
+        if (window->runs != NULL) {
+                FREE(window->lengths);
+                FREE(window->runs);
+        }
+        FREE(window->bytes);
+        FREE(window->fields);
+        FREE(window->blocks);
+        if (window->fixed != NULL) {
+                Fixed_free(&window->fixed);
+        }
+        FREE(window->pixels);
+}
+
+/*****************************encode_strip**********************************
+*
+* Compresses the block rows [first, last) of the window into code words. An 
+* apply function for Parallel_for, so it may run on its own thread.
+*
+* Notes: relies on the getCompressedRow function in the conversion.h interface
+*        to compress each whole block row, on quantize_row to turn the values
+*        of each block into code word fields, and on Codeword_pack_row to 
+*        pack the whole row of fields into bytes. The fixed-point compressor 
+*        does the work of both getCompressedRow and quantize_row, and its 
+*        time is counted as conversion. Run-length coding a row is counted as
+*        output. With a codec, Blockdct_encode_row does all of the work, 
+*        which is counted as conversion.
 *
 *********************************************************************/
-void pack_block(Compressed compressed)
+void encode_strip(int first, int last, void *cl)
 {
-        /* Create indices for chroma */
-        unsigned pb_bar = Arith40_index_of_chroma(compressed.avg_pb);
-        unsigned pr_bar = Arith40_index_of_chroma(compressed.avg_pr);
-
-        /* Scale coefficients to discrete cosine */
-        Vec4f dct_coeffs = compressed.dct_coeffs;
-        unsigned a_scaled = round(dct_coeffs[0] * 63.0);
-        int b_scaled = scale_DCT(dct_coeffs[1]);
-        int c_scaled = scale_DCT(dct_coeffs[2]);
-        int d_scaled = scale_DCT(dct_coeffs[3]);
-        FREE(dct_coeffs);
-
-        /* Create code word and print in big endian order */
-        uint64_t codeword = make_codeword(pb_bar, pr_bar, a_scaled, b_scaled, 
-                                                c_scaled, d_scaled);
-        for (int i = 3; i >= 0; i--) {
-                putchar(((unsigned char *) (&codeword))[i]);
+        struct Window *window = cl;
+        int width = window->width;
+        int count = window->count;
+        struct Stats_mark mark = Stats_start();
+        for (int block_row = first; block_row < last; block_row++) {
+                long offset = (long) block_row * count;
+                if (window->codec != NULL) {
+                        unsigned side = Blockdct_size(window->codec);
+                        Blockdct_encode_row(window->codec, window->pixels +
+                                            (long) side * block_row * width,
+                                            width, count, window->bytes + 
+                                            Blockdct_bytes(window->codec) * 
+                                            offset);
+                        Stats_lap(STATS_CONVERT, &mark);
+                        continue;
+                }
+                struct Pnm_rgb *top = window->pixels + 
+                                      2L * block_row * width;
+                struct Codeword_row fields = 
+                        Codeword_row_at(window->fields, window->size, offset);
+                if (window->fixed != NULL) {
+                        Fixed_quantize_row(window->fixed, top, top + width, 
+                                           count, fields);
+                        Stats_lap(STATS_CONVERT, &mark);
+                } else {
+                        getCompressedRow(top, top + width, count, 
+                                         window->denominator, 
+                                         window->blocks + offset);
+                        Stats_lap(STATS_CONVERT, &mark);
+                        quantize_row(window->blocks + offset, count, fields);
+                }
+                Codeword_pack_row(fields, count, window->bytes + 4 * offset);
+                Stats_lap(STATS_QUANTIZE, &mark);
+                if (window->runs != NULL) {
+                        window->lengths[block_row] = Runs_encode_row(
+                                window->bytes + 4 * offset, count,
+                                window->runs + block_row * 
+                                               window->max_length);
+                        Stats_lap(STATS_OUTPUT, &mark);
+                }
         }
 }
 
-/*****************************scale_DCT**********************************
+/*****************************write_strip**********************************
 *
-* Converts the given coefficient to a DCT value
+* Hands the code words for the block rows [first, last) of the window to the
+* Outbuf, or to the tiles, or their runs to the Outbuf
 *
-* Parameters: double coefficient: the coefficient for a particular pixel 
+*********************************************************************/
+void write_strip(int first, int last, void *cl)
+{
+        struct Window *window = cl;
+        struct Stats_mark mark = Stats_start();
+        if (window->runs != NULL) {
+                for (int row = first; row < last; row++) {
+                        Outbuf_put_bytes(window->out, window->runs + 
+                                         row * window->max_length, 
+                                         window->lengths[row]);
+                }
+        } else if (window->tiles != NULL) {
+                for (int row = first; row < last; row++) {
+                        Tiles_write_row(window->tiles, window->bytes + 
+                                        4L * row * window->count, 
+                                        window->out);
+                }
+        } else {
+                long word_bytes = window->codec != NULL ? 
+                                  Blockdct_bytes(window->codec) : 4;
+                Outbuf_put_bytes(window->out, window->bytes + 
+                                 word_bytes * first * window->count, 
+                                 word_bytes * (last - first) * window->count);
+        }
+        Stats_lap(STATS_OUTPUT, &mark);
+}
+
+/*****************************decompress_stream*****************************
+*
+* Decompresses the code words of an image a window of block rows at a time,
+* writing the raw PPM raster of each window as soon as it is decoded
 *
-* Expects: None
+* Parameters: FILE *input: a compressed image, positioned after its header
+*             unsigned width, height: the size of the image, from its header
+*             Blockdct_T codec: the codec of larger blocks (format 6), or 
+*                               NULL for 2 by 2 ones
+*             Outbuf_T out: where to write the raster
 *
-* Return: an integer containing the scaled value of the coefficient  
+* Expects: input and out are not NULL
+*
+* Return: none, but writes every row of the decompressed image to out
+*
+* Notes: With one thread, the window is a single block row, which is decoded 
+*        into two pixel rows (or as many as codec's blocks have) and 
+*        written before the next is read. With more, each window holds 
+*        STRIP_ROWS block rows per thread and Parallel_for 
+*        decodes one strip per thread; write_raster writes the strips in 
+*        order. Regular files are mapped with the Mapped interface, so their
+*        length is checked once, up front. Anything else, like a pipe, is read
+*        a window at a time. Either way, SHORT_FILE is raised if the file does
+*        not hold every code word, and memory use depends only on the width 
+*        of the image. Any last rows or columns that are not part of a 
+*        block, which the compressor never writes, are left black.
 *
 *********************************************************************/
-int scale_DCT(double coefficient)
+void decompress_stream(FILE *input, unsigned width, unsigned height, 
+                       Blockdct_T codec, Outbuf_T out)
 {
-        /* If coefficient is range, set it to 0.3 or -0.3*/
-        if (coefficient > 0.3) {
-                coefficient = 0.3;
+        int side = codec != NULL ? (int) Blockdct_size(codec) : 2;
+        long word_bytes = codec != NULL ? Blockdct_bytes(codec) : 4;
+        int count = width / side;
+        int rows = height / side;
+        long row_bytes = Ppmstream_row_bytes(width, 255);
+        if (count == 0 || rows == 0) {
+                write_blank_rows(out, row_bytes, height);
+                return;
+        }
+        int window_rows = num_threads == 1 ? 1 : num_threads * STRIP_ROWS;
+        if (window_rows > rows) {
+                window_rows = rows;
         }
 
-        else if (coefficient < -0.3) {
-                coefficient = -0.3;
+        long length = (long) rows * count * word_bytes;
+        struct Stats_mark mark = Stats_start();
+        Mapped_T payload = Mapped_map(input, length, MAPPED_SEQUENTIAL);
+        Stats_lap(STATS_INPUT, &mark);
+        if (payload != NULL && Mapped_length(payload) < length) {
+                Mapped_free(&payload);
+                TRAISE(SHORT_FILE);
         }
 
-        /* Scale coefficient and return */
-        double scaled = coefficient * 103.33;
-        
-        return round(scaled);
+        struct Strips strips = { NULL, width, count, 255, NULL, NULL, 
+                                 (long) window_rows * count, NULL, NULL, NULL,
+                                 row_bytes, out, NULL, NULL, NULL, NULL, 0,
+                                 codec };
+        if (codec == NULL) {
+                if (fixed_point) {
+                        strips.fixed = Fixed_new(strips.denominator);
+                }
+                strips.fields = ALLOC(CODEWORD_NFIELDS * strips.size * 
+                                      sizeof(*strips.fields));
+                strips.blocks = ALLOC(strips.size * sizeof(*strips.blocks));
+                strips.pixels = CALLOC(2L * window_rows * width, 
+                                       sizeof(*strips.pixels));
+        }
+        strips.raster = CALLOC((long) side * window_rows, row_bytes);
+        unsigned char *codes = NULL;
+        if (payload == NULL) {
+                codes = ALLOC(word_bytes * window_rows * count);
+        }
+        for (int done = 0; done < rows; done += window_rows) {
+                if (window_rows > rows - done) {
+                        window_rows = rows - done;
+                }
+                if (payload != NULL) {
+                        strips.payload = Mapped_bytes(payload) + 
+                                         word_bytes * done * count;
+                } else {
+                        size_t want = word_bytes * window_rows * count;
+                        mark = Stats_start();
+                        size_t got = fread(codes, 1, want, input);
+                        Stats_lap(STATS_INPUT, &mark);
+                        if (got != want) {
+                                FREE(codes);
+                                free_strips(&strips);
+                                TRAISE(SHORT_FILE);
+                        }
+                        strips.payload = codes;
+                }
+                Parallel_for(num_threads, window_rows, decode_strip, 
+                             write_raster, &strips);
+        }
+        write_blank_rows(out, row_bytes, height % side);
+
+        if (payload != NULL) {
+                Mapped_free(&payload);
+        } else {
+                FREE(codes);
+        }
+        free_strips(&strips);
 }
 
-/*****************************make_codeword**********************************
+/*****************************decompress_runs*******************************
 *
-* Creates the code word for the given pixel block and prints the code out
+* Decompresses the run-length coded code words of an image (format 5) a 
+* window of block rows at a time, just as decompress_stream does for plain 
+* ones
 *
-* Parameters: unsigned pb_bar: the average pb value for a pixel block
-*             unsigned pr_bar: the average pr value for a pixel block
-*             unsigned int a: the DCT value for the a coefficient
-*             unsigned int b: the DCT value for the b coefficient
-*             unsigned int c: the DCT value for the c coefficient
-*             unsigned int d: the DCT value for the d coefficient
+* Parameters: FILE *input: a compressed image, positioned after its header
+*             unsigned width, height: the size of the image, from its header
+*             Outbuf_T out: where to write the raster
 *
-* Expects: None
+* Expects: input and out are not NULL
 *
-* Return: a 64-bit unsigned int that contains the code word 
+* Return: none, but writes every row of the decompressed image to out
 *
-* Notes: relies on bitpack interface to create the code word from the given
-*        values
+* Notes: The start of each coded block row is found on this thread, before
+*        the window is decoded; regular files are mapped, and anything else
+*        is read one coded row at a time. SHORT_FILE is raised if the file 
+*        ends before the last row, and Runs_Corrupt if a row has too many 
+*        blocks; either way, everything is freed first. decode_strip 
+*        decodes one block of each run.
 *
 *********************************************************************/
-uint64_t make_codeword(unsigned pb_bar, unsigned pr_bar, unsigned int a, int b,
-                        int c, int d)
+void decompress_runs(FILE *input, unsigned width, unsigned height, 
+                     Outbuf_T out)
 {
-        /* Create code word and add values to the word */
-        uint64_t codeword = 0;
+        int count = width / 2;
+        int rows = height / 2;
+        long row_bytes = Ppmstream_row_bytes(width, 255);
+        if (count == 0 || rows == 0) {
+                write_blank_rows(out, row_bytes, height);
+                return;
+        }
+        int window_rows = num_threads == 1 ? 1 : num_threads * STRIP_ROWS;
+        if (window_rows > rows) {
+                window_rows = rows;
+        }
 
-        codeword = Bitpack_newu(codeword, 6, 26, a);
-        codeword = Bitpack_news(codeword, 6, 20, b);
-        codeword = Bitpack_news(codeword, 6, 14, c);
-        codeword = Bitpack_news(codeword, 6, 8, d);
-        codeword = Bitpack_newu(codeword, 4, 4, pb_bar);
-        codeword = Bitpack_newu(codeword, 4, 0, pr_bar);
+        struct Stats_mark mark = Stats_start();
+        Mapped_T payload = Mapped_map(input, LONG_MAX, MAPPED_SEQUENTIAL);
+        Stats_lap(STATS_INPUT, &mark);
+        long offset = 0;
+
+        struct Strips strips = { NULL, width, count, 255, NULL, NULL, 
+                                 (long) window_rows * count, NULL, NULL, NULL,
+                                 row_bytes, out, NULL, NULL, NULL, NULL, 0,
+                                 NULL };
+        if (fixed_point) {
+                strips.fixed = Fixed_new(strips.denominator);
+        }
+        strips.fields = ALLOC(CODEWORD_NFIELDS * strips.size * 
+                              sizeof(*strips.fields));
+        strips.blocks = ALLOC(strips.size * sizeof(*strips.blocks));
+        strips.pixels = CALLOC(2L * window_rows * width, 
+                               sizeof(*strips.pixels));
+        strips.raster = CALLOC(2L * window_rows, row_bytes);
+        strips.rows = ALLOC(window_rows * sizeof(*strips.rows));
+        strips.distinct = ALLOC(4 * strips.size);
+        strips.runs = ALLOC(strips.size * sizeof(*strips.runs));
+        strips.compact = ALLOC(2L * window_rows * row_bytes);
+        long max_length = Runs_max_length(count);
+        unsigned char *codes = NULL;
+        if (payload == NULL) {
+                codes = ALLOC(window_rows * max_length);
+        }
+        TTRY
+                for (int done = 0; done < rows; done += window_rows) {
+                        if (window_rows > rows - done) {
+                                window_rows = rows - done;
+                        }
+                        mark = Stats_start();
+                        for (int row = 0; row < window_rows; row++) {
+                                strips.rows[row] = next_coded_row(input, 
+                                        payload, &offset, codes == NULL ? 
+                                        NULL : codes + row * max_length, 
+                                        count);
+                                if (strips.rows[row] == NULL) {
+                                        TRAISE(SHORT_FILE);
+                                }
+                        }
+                        Stats_lap(STATS_INPUT, &mark);
+                        Parallel_for(num_threads, window_rows, decode_strip,
+                                     write_raster, &strips);
+                }
+        TELSE
+                if (payload != NULL) {
+                        Mapped_free(&payload);
+                }
+                FREE(codes);
+                free_strips(&strips);
+                TRERAISE;
+        TEND_TRY;
+        write_blank_rows(out, row_bytes, height % 2);
 
-        return codeword;
+        if (payload != NULL) {
+                Mapped_free(&payload);
+        } else {
+                FREE(codes);
+        }
+        free_strips(&strips);
 }
 
-/*****************************decode_2by2**********************************
+/*****************************next_coded_row********************************
+*
+* Finds the next run-length coded block row of count blocks, either in the 
+* mapped payload, starting *offset bytes in, or, if payload is NULL, by 
+* reading it from input into buffer
 *
-* Decompresses the pixels from the provided file and stores the results in the
-* given UArray2
+* Return: the coded row, or NULL if the input ends first. *offset is moved 
+*         past the row.
 *
-* Parameters: A2 arr: an UArray2 to store the decompressed values
-*             A2Methods_T methods: a methods suite for the UArray2
-*             unsigned denominator: the denominator for the new image
-*             int col: a column for a pixel in the array
-*             int row: a row for a pixel in the array
-*             FILE *fp: a file that contains a compressed image
+*********************************************************************/
+const unsigned char *next_coded_row(FILE *input, Mapped_T payload, 
+                                    long *offset, unsigned char *buffer, 
+                                    int count)
+{
+        const unsigned char *row = buffer;
+        long length;
+        if (payload != NULL) {
+                row = Mapped_length(payload) > *offset ? 
+                      Mapped_bytes(payload) + *offset : NULL;
+                length = Runs_row_length(row, Mapped_length(payload) - 
+                                              *offset, count);
+        } else {
+                length = Runs_read_row(input, buffer, count);
+        }
+        if (length < 0) {
+                return NULL;
+        }
+        *offset += length;
+        return row;
+}
+
+/*****************************decompress_region*****************************
 *
-* Expects: Expects that the UArray2 is not NULL, which is checked in the 
-*          decompress40 function
+* Decompresses the pixels of a rectangle of an image, a window of block rows
+* at a time
 *
-* Return: none, but updates the UArray2 to contain the decompressed values
+* Parameters: FILE *input: a compressed image, positioned after its header 
+*                          (and tile index)
+*             unsigned width, height: the size of the image
+*             Tiles_T tiles: the layout of the tiles, or NULL for an image 
+*                            that is not tiled
+*             int runs: nonzero if the image is run-length coded
+*             int thumbnail: nonzero to decode one pixel per block
+*             unsigned x, y, w, h: the rectangle, which lies in the image, 
+*                                  or in its thumbnail
+*             Outbuf_T out: where to write the raster of the rectangle
 *
-* Notes: Relies on the conversion interface to unpack the code word and store
-*        the values in the array. Calls decode_codeword to decode the code word 
-*        beforehand. 
+* Return: nothing, but writes every row of the rectangle to out
 *
+* Notes: The rest of input is mapped with the Mapped interface (or read, if
+*        it is a pipe), and SHORT_FILE is raised if it does not hold every 
+*        code word. Unless the rectangle covers every block, only the pages
+*        under it are touched, so the mapping is then advised as random 
+*        access rather than sequential. For each block row in the 
+*        rectangle, the code words of the blocks that cover it are gathered
+*        into one row, from the tiles or straight from a plain image, and 
+*        then decoded by decode_strip exactly as decompress_stream does. 
+*        write_region crops the rows. The rows of a run-length coded image
+*        can only be found one after another, so every row above the 
+*        rectangle is scanned (but not decoded) too; regular files are 
+*        mapped, and anything else read one coded row at a time. 
+*        Everything is freed before SHORT_FILE, or an exception from the 
+*        Runs or Tiles interface, goes on to the caller.
 *********************************************************************/
-void decode_2by2(A2 arr, A2Methods_T methods, unsigned denominator, 
-        int col, int row, void *cl)
+void decompress_region(FILE *input, unsigned width, unsigned height, 
+                       Tiles_T tiles, int runs, int thumbnail, unsigned x, 
+                       unsigned y, unsigned w, unsigned h, Outbuf_T out)
 {
-        /* Map through each 2x2 block in the UArray2 and get code words*/
-        assert(arr != NULL);
-        FILE *fp = cl;
-        uint32_t codeword = 0;
-        for (int i = 3 ; i >= 0; i--) {
-                int read = fgetc(fp);
-                if (read == EOF) {
-                        RAISE(SHORT_FILE);
+        /* The number of pixels on a side of each block */
+        unsigned side = thumbnail ? 1 : 2;
+        int count = width / 2;
+        int rows = height / 2;
+        int first_col = x / side;
+        int last_col = (x + w + side - 1) / side < (unsigned) count ? 
+                       (int) ((x + w + side - 1) / side) : count;
+        int first_row = y / side;
+        int last_row = (y + h + side - 1) / side < (unsigned) rows ? 
+                       (int) ((y + h + side - 1) / side) : rows;
+
+        long length = tiles != NULL ? Tiles_payload_length(tiles) : 
+                                      4L * rows * count;
+        struct Stats_mark mark = Stats_start();
+        int whole = first_row == 0 && last_row == rows && first_col == 0 &&
+                    last_col == count;
+        Mapped_T payload = runs ? 
+                Mapped_map(input, LONG_MAX, MAPPED_SEQUENTIAL) :
+                Mapped_input(input, length, whole ? MAPPED_SEQUENTIAL : 
+                                                    MAPPED_RANDOM);
+        Stats_lap(STATS_INPUT, &mark);
+        if (!runs && Mapped_length(payload) < length) {
+                Mapped_free(&payload);
+                TRAISE(SHORT_FILE);
+        }
+
+        /* Rows past the last block row are black */
+        unsigned decoded = last_row > first_row ? side * last_row - y : 0;
+        decoded = decoded < h ? decoded : h;
+        long out_bytes = Ppmstream_row_bytes(w, 255);
+        if (first_col >= last_col) {
+                write_blank_rows(out, out_bytes, h);
+                if (payload != NULL) {
+                        Mapped_free(&payload);
                 }
-                ((unsigned char *) (&codeword))[i] = (unsigned char) read;
+                return;
         }
 
-        /* Decode code word and add pixels to array */
-        Compressed compressed = decode_codeword(codeword);
+        int span = last_col - first_col;
+        int window_rows = num_threads == 1 ? 1 : num_threads * STRIP_ROWS;
+        struct Region region;
+        struct Strips *strips = &region.strips;
+        strips->width = 2 * span;
+        strips->count = span;
+        strips->denominator = 255;
+        strips->fixed = fixed_point ? Fixed_new(255) : NULL;
+        strips->size = (long) window_rows * span;
+        strips->fields = ALLOC(CODEWORD_NFIELDS * strips->size * 
+                               sizeof(*strips->fields));
+        strips->blocks = ALLOC(strips->size * sizeof(*strips->blocks));
+        strips->pixels = CALLOC(2L * window_rows * strips->width, 
+                                sizeof(*strips->pixels));
+        /* One more pixel per row, for a last odd column */
+        strips->row_bytes = Ppmstream_row_bytes(strips->width + 1, 255);
+        strips->raster = CALLOC(2L * window_rows, strips->row_bytes);
+        strips->out = out;
+        strips->rows = NULL;
+        strips->thumbnail = thumbnail;
+        strips->codec = NULL;
+        region.y = y;
+        region.h = decoded;
+        region.crop = Ppmstream_row_bytes(x - side * first_col, 255);
+        region.out_bytes = out_bytes;
+        unsigned char *codes = ALLOC(4L * strips->size);
+        strips->payload = codes;
 
-        setPixels(arr, methods, col, row, denominator, compressed);
-        FREE(compressed.dct_coeffs);
+        /* The coded row being read, and the rows that come before it */
+        long offset = 0;
+        unsigned char *buffer = NULL;
+        if (runs && payload == NULL) {
+                buffer = ALLOC(Runs_max_length(count));
+        }
+        const unsigned char *coded = NULL;
+        int next_row = 0;
+
+        const unsigned char *bytes = payload != NULL ? Mapped_bytes(payload)
+                                                     : NULL;
+        TTRY
+                for (int done = first_row; done < last_row; 
+                     done += window_rows) {
+                        int n = last_row - done < window_rows ? 
+                                last_row - done : window_rows;
+                        mark = Stats_start();
+                        for (int row = 0; row < n; row++) {
+                                unsigned char *to = codes + 4L * row * span;
+                                while (runs && next_row <= done + row) {
+                                        coded = next_coded_row(input, 
+                                                payload, &offset, buffer, 
+                                                count);
+                                        next_row++;
+                                        if (coded == NULL) {
+                                                TRAISE(SHORT_FILE);
+                                        }
+                                }
+                                gather_row(tiles, bytes, runs ? coded : NULL,
+                                           count, done + row, first_col, 
+                                           last_col, to);
+                        }
+                        Stats_lap(STATS_QUANTIZE, &mark);
+                        region.done = done;
+                        Parallel_for(num_threads, n, decode_strip, 
+                                     write_region, &region);
+                }
+        TELSE
+                if (payload != NULL) {
+                        Mapped_free(&payload);
+                }
+                if (buffer != NULL) {
+                        FREE(buffer);
+                }
+                FREE(codes);
+                free_strips(strips);
+                TRERAISE;
+        TEND_TRY;
+        write_blank_rows(out, out_bytes, h - decoded);
 
+        if (payload != NULL) {
+                Mapped_free(&payload);
+        }
+        if (buffer != NULL) {
+                FREE(buffer);
+        }
+        FREE(codes);
+        free_strips(strips);
 }
 
-/*****************************decode_codeword**********************************
+/*****************************gather_row************************************
 *
-* Unpacks the given code word, unscales the DCT values, and converts the indic-
-* es back to chroma
+* Gathers the code words of the blocks [first_col, last_col) of block row row
+* into to: from the coded row of a run-length coded image if coded is not 
+* NULL, or else from the tiles, or else straight from the code words of a 
+* plain image, all count blocks a row, in bytes
 *
-* Parameters: uint64_t codeword: a codeword to decode
+*********************************************************************/
+void gather_row(Tiles_T tiles, const unsigned char *bytes, 
+                const unsigned char *coded, int count, int row, 
+                int first_col, int last_col, unsigned char *to)
+{
+        if (coded != NULL) {
+                Runs_gather(coded, count, first_col, last_col, to);
+        } else if (tiles != NULL) {
+                Tiles_gather(tiles, bytes, row, first_col, last_col, to);
+        } else {
+                memcpy(to, bytes + 4L * ((long) row * count + first_col),
+                       4L * (last_col - first_col));
+        }
+}
+
+/*****************************decode_strip**********************************
 *
-* Expects: None
+* Decompresses the block rows [first, last) of the window and packs them into
+* the raster. An apply function for Parallel_for, so it may run on its own 
+* thread, and it writes only to the rows of its own strip. Packing the 
+* pixels into raw bytes is counted as output, and the fixed-point decoder as
+* conversion.
 *
-* Return: a "Compressed" vector of doubles that contains the decompressed values
+* Notes: A run-length coded row with runs in it is decoded as a row of just
+*        one block per run, into the compact raster, and then each block's 
+*        bytes are copied once for every block of its run. Copying the 
+*        bytes is counted as output. A thumbnail row is decoded straight 
+*        from the fields, one pixel per block. With a codec, each block row
+*        fills as many raster rows as its blocks have, with 
+*        Blockdct_decode_row doing all of the work, counted as conversion.
 *
-* Notes: Relies on the bitpack interface to get the values from the code word
-*        and the Arith40 interface to get the average chroma from the indices
+*********************************************************************/
+void decode_strip(int first, int last, void *cl)
+{
+        struct Strips *strips = cl;
+        int width = strips->width;
+        int count = strips->count;
+        long row_bytes = strips->row_bytes;
+        long block_bytes = Ppmstream_row_bytes(2, strips->denominator);
+        struct Stats_mark mark = Stats_start();
+        for (int block_row = first; block_row < last; block_row++) {
+                long offset = (long) block_row * count;
+                if (strips->codec != NULL) {
+                        unsigned side = Blockdct_size(strips->codec);
+                        Blockdct_decode_row(strips->codec, strips->payload +
+                                            Blockdct_bytes(strips->codec) * 
+                                            offset, count, strips->raster + 
+                                            (long) side * block_row * 
+                                            row_bytes, row_bytes);
+                        Stats_lap(STATS_CONVERT, &mark);
+                        continue;
+                }
+                struct Codeword_row fields = 
+                        Codeword_row_at(strips->fields, strips->size, offset);
+                Compressed *blocks = strips->blocks + offset;
+                struct Pnm_rgb *top = strips->pixels + 2L * block_row * width;
+                unsigned char *raster = strips->raster + 
+                                        2L * block_row * row_bytes;
+
+                /* n blocks are decoded, into packed_width pixels of packed */
+                const unsigned char *codes = strips->payload + 4 * offset;
+                int n = count;
+                int packed_width = width;
+                const int *runs = NULL;
+                unsigned char *packed = raster;
+                if (strips->rows != NULL) {
+                        codes = strips->distinct + 4 * offset;
+                        n = Runs_split_row(strips->rows[block_row], count, 
+                                           strips->distinct + 4 * offset, 
+                                           strips->runs + offset);
+                        if (n < count) {
+                                runs = strips->runs + offset;
+                                packed = strips->compact + 
+                                         2L * block_row * row_bytes;
+                                packed_width = 2 * n;
+                        }
+                }
+                Codeword_unpack_row(codes, n, fields);
+                if (strips->thumbnail) {
+                        Stats_lap(STATS_QUANTIZE, &mark);
+                        if (strips->fixed != NULL) {
+                                Fixed_thumbnail_row(strips->fixed, fields, 
+                                                    count, raster);
+                        } else {
+                                setThumbnailRow(fields, count, 
+                                                strips->denominator, top);
+                                Ppmstream_pack_row(top, count, 
+                                                   strips->denominator, 
+                                                   raster);
+                        }
+                        Stats_lap(STATS_CONVERT, &mark);
+                        continue;
+                }
+                if (strips->fixed != NULL) {
+                        Stats_lap(STATS_QUANTIZE, &mark);
+                        Fixed_decode_row(strips->fixed, fields, n, packed,
+                                         packed + row_bytes);
+                        Stats_lap(STATS_CONVERT, &mark);
+                } else {
+                        dequantize_row(fields, n, blocks);
+                        Stats_lap(STATS_QUANTIZE, &mark);
+                        setPixelsRow(blocks, n, strips->denominator, top, 
+                                     top + width);
+                        Stats_lap(STATS_CONVERT, &mark);
+                        Ppmstream_pack_row(top, packed_width, 
+                                           strips->denominator, packed);
+                        Ppmstream_pack_row(top + width, packed_width, 
+                                           strips->denominator, 
+                                           packed + row_bytes);
+                        Stats_lap(STATS_OUTPUT, &mark);
+                }
+                if (runs != NULL) {
+                        Runs_expand(packed, runs, n, block_bytes, raster);
+                        Runs_expand(packed + row_bytes, runs, n, block_bytes,
+                                    raster + row_bytes);
+                        Stats_lap(STATS_OUTPUT, &mark);
+                }
+        }
+}
+
+/*****************************free_strips***********************************
+*
+* Frees the buffers of a Strips, and its fixed-point decoder if it has one
 *
 *********************************************************************/
-Compressed decode_codeword(uint64_t codeword)
+void free_strips(struct Strips *strips)
 {
-        /* Get values from the code word */
-        uint64_t a_scaled = Bitpack_getu(codeword, 6, 26);
-        int64_t b_scaled = Bitpack_gets(codeword, 6, 20);
-        int64_t c_scaled = Bitpack_gets(codeword, 6, 14);
-        int64_t d_scaled = Bitpack_gets(codeword, 6, 8);
-        uint64_t pb_bar = Bitpack_getu(codeword, 4, 4);
-        uint64_t pr_bar = Bitpack_getu(codeword, 4, 0);
-
-        /* Unscale the coefficients and place in new compressed vector */
-        Compressed compressed;
-        compressed.dct_coeffs = vec_new(4);
-        compressed.dct_coeffs[0] = a_scaled / 63.0;
-        compressed.dct_coeffs[1] = unscale_DCT(b_scaled);
-        compressed.dct_coeffs[2] = unscale_DCT(c_scaled);
-        compressed.dct_coeffs[3] = unscale_DCT(d_scaled);
-
-        compressed.avg_pb = Arith40_chroma_of_index(pb_bar);
-        compressed.avg_pr = Arith40_chroma_of_index(pr_bar);
-
-        return compressed;
+        FREE(strips->raster);
+        FREE(strips->pixels);
+        FREE(strips->blocks);
+        FREE(strips->fields);
+        if (strips->rows != NULL) {
+                FREE(strips->compact);
+                FREE(strips->runs);
+                FREE(strips->distinct);
+                FREE(strips->rows);
+        }
+        if (strips->fixed != NULL) {
+                Fixed_free(&strips->fixed);
+        }
 }
 
-/*****************************unscale_DCT**********************************
+/*****************************write_raster**********************************
+*
+* Writes the raster for the block rows [first, last) of the window out 
+* through the Outbuf
 *
-* Reverses the scaling of the DCT value 
+* Notes: Flushes before returning, so every block row reaches the output as
+*        soon as it and the rows above it are decoded
 *
-* Parameters: int scaled: a scale DCT value to scale back down
+*********************************************************************/
+void write_raster(int first, int last, void *cl)
+{
+        struct Strips *strips = cl;
+        long side = strips->codec != NULL ? Blockdct_size(strips->codec) : 2;
+        long block_row_bytes = side * strips->row_bytes;
+        struct Stats_mark mark = Stats_start();
+        Outbuf_put_bytes(strips->out, strips->raster + first * block_row_bytes,
+                         (last - first) * block_row_bytes);
+        Outbuf_flush(strips->out);
+        Stats_lap(STATS_OUTPUT, &mark);
+}
+
+/*****************************write_region**********************************
+*
+* Writes the part of the rows of block rows [first, last) of the window 
+* that lies in the rectangle out through the Outbuf, flushing it at the end
+* just as write_raster does
+*
+*********************************************************************/
+void write_region(int first, int last, void *cl)
+{
+        struct Region *region = cl;
+        struct Strips *strips = &region->strips;
+        int side = strips->thumbnail ? 1 : 2;
+        struct Stats_mark mark = Stats_start();
+        for (int row = 2 * first; row < 2 * last; row++) {
+                if (row % 2 >= side) {
+                        continue;
+                }
+                long pixel_row = (long) side * (region->done + row / 2) + 
+                                 row % 2;
+                if (pixel_row >= region->y && 
+                    pixel_row < (long) region->y + region->h) {
+                        Outbuf_put_bytes(strips->out, strips->raster + 
+                                         row * strips->row_bytes + 
+                                         region->crop, region->out_bytes);
+                }
+        }
+        Outbuf_flush(strips->out);
+        Stats_lap(STATS_OUTPUT, &mark);
+}
+
+/*****************************write_blank_rows******************************
+*
+* Writes rows of black pixels, each row_bytes long, to the Outbuf
+*
+*********************************************************************/
+void write_blank_rows(Outbuf_T out, long row_bytes, unsigned rows)
+{
+        if (rows == 0 || row_bytes == 0) {
+                return;
+        }
+        struct Stats_mark mark = Stats_start();
+        unsigned char *blank = CALLOC(row_bytes, 1);
+        for (unsigned i = 0; i < rows; i++) {
+                Outbuf_put_bytes(out, blank, row_bytes);
+        }
+        FREE(blank);
+        Stats_lap(STATS_OUTPUT, &mark);
+}
+
+/*****************************output_capacity******************************
 *
-* Expects: None
+* Returns the size of an Outbuf for decompressed output: rows rows of a raw
+* raster width pixels wide, which is one block row
 *
-* Return: a double containing the unscaled coefficient of the DCT
+* Notes: write_raster and write_region flush after every call, so a larger
+*        buffer would never fill. A whole block row is at least as large as
+*        this and goes straight to the FILE without being copied.
 *
 *********************************************************************/
-double unscale_DCT(int scaled) 
+long output_capacity(unsigned rows, unsigned width)
 {
-        /* Unscale value and return */
-        return ((double) scaled / 103.33);
+        long bytes = rows * Ppmstream_row_bytes(width, 255);
+        return bytes >= 4 ? bytes : 4;
 }
 
-#undef A2
\ No newline at end of file
+#undef STRIP_ROWS
@@ -0,0 +1,88 @@
+/*
+ *     compress40.h
+ *     by Abhinav Mummameni (amumma01) and Rolando Ortega (rorteg02)
+ *
+ *     Interface for compressing and decompressing images. compress40 and 
+ *     decompress40 are the functions from the course's interface; the 
+ *     remaining functions configure how they do their work.
+ */
+
+#ifndef COMPRESS40_INCLUDED
+#define COMPRESS40_INCLUDED
+
+#include <stdio.h>
+#include "except.h"
+
+/* Raised, with TRAISE (see texcept.h), when a compressed image ends before
+ * its last code word, its header is not one of a format that is read, a 
+ * region does not lie inside the image, or a region or thumbnail is asked
+ * of a format 6 image */
+extern Except_T SHORT_FILE;
+extern Except_T BAD_HEADER;
+extern Except_T BAD_REGION;
+extern Except_T NO_REGIONS;
+
+extern void compress40  (FILE *input);  /* reads PPM, writes compressed image */
+extern void decompress40(FILE *input);  /* reads compressed image, writes PPM */
+
+/* Like compress40 and decompress40, but write to output instead of stdout.
+ * Different images may be processed on different threads at once, as long
+ * as no compress40_set function is called meanwhile. A bad input raises 
+ * its exception (Pnm_Badformat, SHORT_FILE, BAD_HEADER or the exceptions 
+ * of the Tiles, Entropy and Runs interfaces) with TRAISE, so a TTRY block
+ * on the calling thread can handle it and go on; everything but what was 
+ * already written to output is freed. Checked runtime errors, running out
+ * of memory and write errors are CII exceptions, which are shared by all 
+ * threads. */
+extern void compress40_to  (FILE *input, FILE *output);
+extern void decompress40_to(FILE *input, FILE *output);
+
+/* Like decompress40_to, but writes only the w by h rectangle of the image 
+ * whose top left pixel is at column x, row y. Reads every format but 6, 
+ * for which it raises NO_REGIONS, but from a tiled image only needs to 
+ * read the tiles that the rectangle covers. Raises BAD_REGION if the 
+ * rectangle is empty or does not lie inside the image. */
+extern void decompress40_region(FILE *input, FILE *output, unsigned x, 
+                                unsigned y, unsigned w, unsigned h);
+
+/* Like decompress40_to, but writes a thumbnail of half the width and height
+ * of the image, with one pixel per block made from the block's average luma
+ * and chroma alone. Reads every format but 6, for which it raises 
+ * NO_REGIONS. */
+extern void decompress40_thumbnail(FILE *input, FILE *output);
+
+/* Sets the number of threads used to compress or decompress an image 
+ * (default 1). 
+ * Checked runtime error if nthreads is 0. */
+extern void compress40_set_threads(unsigned nthreads);
+
+/* Selects the fixed-point codec (nonzero) or the floating point one (0, the
+ * default) for both compression and decompression */
+extern void compress40_set_fixed_point(int enabled);
+
+/* Makes compress40 write tiled images ("COMP40 Compressed image format 3")
+ * with square tiles of the given size in pixels, or plain images (format 2,
+ * the default) if it is 0. Checked runtime error if pixels is odd. */
+extern void compress40_set_tile_size(unsigned pixels);
+
+/* Makes compress40 entropy code the code words of each tile ("COMP40 
+ * Compressed image format 4") if enabled is nonzero. The pixels that come 
+ * back out are exactly the same. */
+extern void compress40_set_entropy_coding(int enabled);
+
+/* Makes compress40 run-length code repeated code words ("COMP40 Compressed 
+ * image format 5") if enabled is nonzero. Compressing with run-length 
+ * coding and tiles or entropy coding is a checked runtime error. Each run 
+ * of identical blocks is decoded only once. */
+extern void compress40_set_run_length(int enabled);
+
+/* Makes compress40 encode blocks of 4 by 4 or 8 by 8 pixels, each with a 
+ * DCT of its own and a larger code word ("COMP40 Compressed image format 
+ * 6"), or the usual 2 by 2 blocks (the default). Checked runtime error if 
+ * pixels is not 2, 4 or 8. Format 6 images cannot be tiled or coded, or 
+ * use the fixed-point codec, and compressing with any of those and larger 
+ * blocks is a checked runtime error. decompress40_region and 
+ * decompress40_thumbnail do not read them. */
+extern void compress40_set_block_size(unsigned pixels);
+
+#endif
@@ -12,12 +12,18 @@
 #include "assert.h"
 #include "except.h"
 #include "pnm.h"
-#include "a2plain.h"
 #include "mem.h"
 #include "conversion.h"
-#define A2 A2Methods_UArray2
+#include "chroma.h"
+#if defined(__GNUC__) && defined(__x86_64__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
 #define BlockWidth 2
 #define BlockHeight 2
+/* Blocks whose chroma setThumbnailRow looks up at once */
+#define THUMBNAIL_CHUNK 64
 /* Definitions for indices of fields of rgb values */
 #define RED  0
 #define GREEN  1
@@ -54,30 +60,30 @@ floating DCT_TO_LUMAS[4][4] = {
 };
 /***************************MatfMultiply**********************************
 *
-*  Performs a Matrix Vector multiplication and returns the result
+*  Performs a Matrix Vector multiplication and stores the result
 *
 * Parameters: floating (*mat)[]: A square matrix of floating type elements
-*             Vecf vec: The vector to multiply
+*             const floating *vec: The vector to multiply
+*             floating *result: Where the product should be written
               int size: The size of the vector which should be the same as the 
                 size of the matrix.
 *
-* Expects: The matrix and vector should both be of size, size.
-           The caller must free the resulting vector.
+* Expects: The matrix, vector and result should all be of size, size, and
+           result must not alias vec.
 *
-* Return: Returns the result of the matrix vector multiplication, a new vector.
+* Return: void, but result holds the matrix vector product.
 *
 *********************************************************************/
-Vecf MatfMultiply(floating (*mat)[], Vecf vec, int size) 
+void MatfMultiply(floating (*mat)[], const floating *vec, floating *result, 
+                  int size) 
 {
         floating (*matrix)[size] = mat;
-        Vecf result = vec_new(size);
         for (int i = 0; i < size; i++) {
                 result[i] = 0.0;
                 for (int j = 0; j < size; j++) {
                         result[i] += (matrix[i][j] * vec[j]);
                 }
         }
-        return result;
 }
 
 /***************************pixel_to_rgb**********************************
@@ -86,16 +92,15 @@ Vecf MatfMultiply(floating (*mat)[], Vecf vec, int size)
               unsigned denominator: The denominator of the image which the pixel
                 belongs to.
 * Expects: Denominator should be non-zero and pixel should be a valid Pnm_rgb
-           The caller must free the resulting rgb Vec3f.
 * Return: The converted floating number representation of the pixel as a 
            Vec3f rgb.
 *********************************************************************/
 Vec3f pixel_to_rgb(Pnm_rgb pixel, unsigned denominator) 
 {
-        Vec3f rgb = vec_new(3);
-        rgb[RED] = ((floating)pixel->red / (floating) denominator);
-        rgb[GREEN] = ((floating)pixel->green / (floating) denominator);
-        rgb[BLUE] = ((floating)pixel->blue / (floating) denominator);
+        Vec3f rgb;
+        rgb.v[RED] = ((floating)pixel->red / (floating) denominator);
+        rgb.v[GREEN] = ((floating)pixel->green / (floating) denominator);
+        rgb.v[BLUE] = ((floating)pixel->blue / (floating) denominator);
 
         return rgb;
 }
@@ -112,7 +117,9 @@ The following 4 functions are wrappers of MatfMultiply for specific use cases.
 *********************************************************************/
 Vec3f rgb_to_cspace(Vec3f rgb) 
 {
-        return MatfMultiply(RGB_TO_COLORSPACE, rgb, 3);
+        Vec3f cspace;
+        MatfMultiply(RGB_TO_COLORSPACE, rgb.v, cspace.v, 3);
+        return cspace;
 }
 
 /***************************lumas_to_dct**********************************
@@ -124,7 +131,9 @@ Vec3f rgb_to_cspace(Vec3f rgb)
 *********************************************************************/
 Vec4f lumas_to_dct(Vec4f lumas) 
 {
-        return MatfMultiply(LUMAS_TO_DCT, lumas, 4);
+        Vec4f dct;
+        MatfMultiply(LUMAS_TO_DCT, lumas.v, dct.v, 4);
+        return dct;
 }
 
 /***************************dct_to_lumas**********************************
@@ -136,7 +145,9 @@ values
 *********************************************************************/
 Vec4f dct_to_lumas(Vec4f dct) 
 {
-        return MatfMultiply(DCT_TO_LUMAS, dct, 4);
+        Vec4f lumas;
+        MatfMultiply(DCT_TO_LUMAS, dct.v, lumas.v, 4);
+        return lumas;
 }
 
 /***************************cspace_to_rgb**********************************
@@ -147,7 +158,31 @@ Vec4f dct_to_lumas(Vec4f dct)
 *********************************************************************/
 Vec3f cspace_to_rgb(Vec3f cspace) 
 {
-        return MatfMultiply(COLORSPACE_TO_RGB, cspace, 3);
+        Vec3f rgb;
+        MatfMultiply(COLORSPACE_TO_RGB, cspace.v, rgb.v, 3);
+        return rgb;
+}
+
+/***************************scale_channel**********************************
+*  Scales a floating channel value up to the given denominator
+* Parameters: floating value: A channel value, nominally between 0 and 1
+              unsigned denominator: The denominator to scale to
+* Expects: Denominator should be non-zero
+* Return: The rounded channel value, clamped to [0, denominator]
+* Notes: Values that fall outside of the range after decompression are 
+         clamped, rather than converted to unsigned directly, since that 
+         conversion is undefined for negative numbers.
+*********************************************************************/
+unsigned scale_channel(floating value, unsigned denominator)
+{
+        floating scaled = round(value * (floating) denominator);
+        if (scaled < 0.0) {
+                return 0;
+        }
+        if (scaled > (floating) denominator) {
+                return denominator;
+        }
+        return scaled;
 }
 
 /***************************rgb_to_pixel**********************************
@@ -161,47 +196,9 @@ Vec3f cspace_to_rgb(Vec3f cspace)
 *********************************************************************/
 void rgb_to_pixel(Vec3f rgb, unsigned denominator, Pnm_rgb pixel)
 {
-        pixel->red = round(rgb[RED] * (floating) denominator);
-        pixel->green = round(rgb[GREEN] * (floating) denominator);
-        pixel->blue = round(rgb[BLUE] * (floating) denominator);
-}
-
-/***************************vec_new**********************************
-* Creates a new Vecf object of size size
-* Parameters: unsigned size: The size of the vector.
-* Expects: CRE if size = 0. The caller must free the resulting Vecf.
-* Return: A Vecf with memory allocated to hold size values.
-*********************************************************************/
-Vecf vec_new(unsigned size)
-{
-        assert(size > 0);
-        return ALLOC(sizeof(floating) * size);
-}
-
-/***************************makeBlock**********************************
-* Creates a CSBlock
-* Parameters: none
-* Expects: none
-* Return: A pointer to a CSBlock
-*********************************************************************/
-CSBlock makeBlock() 
-{
-        return ALLOC(sizeof(Vecf) * BlockHeight * BlockWidth);
-}
-
-/***************************deleteBlock**********************************
-* Deletes a CSBlock
-* Parameters: CSBlock block: The block to be deleted
-* Expects: block should be a valid block with valid Vecf elements
-* Return: void
-*********************************************************************/
-void deleteBlock(CSBlock block) 
-{
-        for (int i = 0; i < BlockHeight * BlockWidth; i++) {
-                FREE(block[i]);
-        }
-        FREE(block);
-
+        pixel->red = scale_channel(rgb.v[RED], denominator);
+        pixel->green = scale_channel(rgb.v[GREEN], denominator);
+        pixel->blue = scale_channel(rgb.v[BLUE], denominator);
 }
 
 /***************************Compress_CSBlock**********************************
@@ -209,7 +206,7 @@ void deleteBlock(CSBlock block)
 * Compresses CSBlock cs_block into Compressed compressed. Computes the dct
 coefficients and the average pb and pr values.
 *
-* Parameters: CSBlock cs_block: The block to compress.
+* Parameters: const CSBlock *cs_block: The block to compress.
 *
 * Expects: cs_block should be a valid block
 *
@@ -217,70 +214,47 @@ coefficients and the average pb and pr values.
 average pb and pr values.
 *
 *********************************************************************/
-Compressed Compress_CSBlock(CSBlock cs_block)
+Compressed Compress_CSBlock(const CSBlock *cs_block)
 {
-        Vecf lumas = vec_new(BlockHeight * BlockWidth);
+        Vec4f lumas;
         floating total_pb = 0.0;
         floating total_pr = 0.0;
         for (int i = 0; i < BlockHeight * BlockWidth; i++) {
-                lumas[i] = cs_block[i][LUMA];
-                total_pb += cs_block[i][PB];
-                total_pr += cs_block[i][PR];
+                lumas.v[i] = cs_block->pixels[i].v[LUMA];
+                total_pb += cs_block->pixels[i].v[PB];
+                total_pr += cs_block->pixels[i].v[PR];
         }
         Compressed compressed;
         compressed.dct_coeffs = lumas_to_dct(lumas); 
-        FREE(lumas);
 
         compressed.avg_pb = total_pb / ((floating) (BlockHeight * BlockWidth));
         compressed.avg_pr = total_pr / ((floating) (BlockHeight * BlockWidth));
         return compressed;
 }
 
-/***************************getCompressed*********************************
+/***************************compress_pixels*********************************
 *
-* Converts the 2x2 block of pixels at the given column and row in the array 
-* into color space values. 
+* Converts the 4 pixels of a 2x2 block into its Compressed representation
 *
-* Parameters: A2 array: a UArray2 that stores the decompressed pixels
-*             A2Methods_T methods: a methods suite that contains the functions 
-*                               for a UArray2
-*             int col: a column in the UArray2
-*             int row: a column in the UArray2
-*             unsigned denominator: the denominator for the decompressed image 
+* Parameters: Pnm_rgb pixels[]: the pixels of the block, in row-major order
+*             unsigned denominator: the denominator of the image
 *
-* Expects: None
+* Expects: pixels holds BlockHeight * BlockWidth valid pixels
 * 
-* Returns: A CSBlock that contains the information for each pixel in the block.
+* Returns: The Compressed values (dct coefficients and chroma averages) for 
+*               the block.
 *
-* Notes: Relies on dct_to_lumas to extract the luma values for each pixel and 
-*               makeBlock and vec_new to create and update a CSBlock. Frees the 
-*               memory needed for creating the vector of luma values. 
+* Notes: The CSBlock lives on the stack, so no memory is allocated per block.
 *
 *********************************************************************/
-Compressed getCompressed(A2 array, A2Methods_T methods, int col, int row, 
-                        unsigned denominator) 
-{
-        assert(array != NULL);
-        /* Create block to contain information about pixels */
-        CSBlock cs_block = makeBlock();
-        int i = 0;
-
-        /* Traverse the gibenn block, convert RGB pixel values to color space */
-        for (int block_row = 0; block_row < BlockHeight; block_row++) {
-                for (int block_col = 0; block_col < BlockWidth; block_col++) {
-                        Pnm_rgb pixel = methods->at(array, col + block_col, 
-                                        row + block_row);
-                        Vec3f rgb = pixel_to_rgb(pixel, denominator);
-                        cs_block[i] = rgb_to_cspace(rgb);
-                        FREE(rgb);
-                        i++;
-                }
+Compressed compress_pixels(Pnm_rgb pixels[], unsigned denominator)
+{
+        CSBlock cs_block;
+        for (int i = 0; i < BlockHeight * BlockWidth; i++) {
+                Vec3f rgb = pixel_to_rgb(pixels[i], denominator);
+                cs_block.pixels[i] = rgb_to_cspace(rgb);
         }
-
-        /* Convert information to lumas and pb and pr averages */
-        Compressed compressed = Compress_CSBlock(cs_block);
-        deleteBlock(cs_block);
-        return compressed;
+        return Compress_CSBlock(&cs_block);
 }
 
 /***************************Decompress_CSBlock*********************************
@@ -296,77 +270,636 @@ Compressed getCompressed(A2 array, A2Methods_T methods, int col, int row,
 * 
 * Returns: A CSBlock that contains the information for each pixel in the block.
 *
-* Notes: Relies on dct_to_lumas to extract the luma values for each pixel and 
-*               makeBlock and vec_new to create and update a CSBlock. Frees the 
-*               memory needed for creating the vector of luma values. 
+* Notes: Relies on dct_to_lumas to extract the luma values for each pixel. 
 *
 *********************************************************************/
 CSBlock Decompress_CSBlock(Compressed compressed) {
         /* Extract the luma values from the compressed block */
         Vec4f lumas = dct_to_lumas(compressed.dct_coeffs);
-        CSBlock cs_block = makeBlock();
+        CSBlock cs_block;
 
         /* Get the information for each pixel in the block */
         for (int i = 0; i < BlockHeight * BlockWidth; i++) {
-                cs_block[i] = vec_new(3);
-                cs_block[i][LUMA] = lumas[i];
-                cs_block[i][PB] = compressed.avg_pb;
-                cs_block[i][PR] = compressed.avg_pr;
+                cs_block.pixels[i].v[LUMA] = lumas.v[i];
+                cs_block.pixels[i].v[PB] = compressed.avg_pb;
+                cs_block.pixels[i].v[PR] = compressed.avg_pr;
         }
-        FREE(lumas);
         return cs_block;
 }
 
-/***************************setPixels**********************************
+/***************************decompress_pixels*******************************
 *
-* Decompresses a block of pixels at the given column and row of an image and 
-* stores the decompressed pixels in a UArray2.
+* Converts a Compressed block back into the 4 pixels of a 2x2 block
 *
-* Parameters: A2 array: a UArray2 that stores the decompressed pixels
-*             A2Methods_T methods: a methods suite that contains the functions 
-*                               for a UArray2
-*             int col: a column in the UArray2
-*             int row: a column in the UArray2
+* Parameters: Compressed compressed: data from a code word
 *             unsigned denominator: the denominator for the decompressed image
-*             Compressed compressed: data from a code word that will be 
-*                               further decompressed. 
+*             Pnm_rgb pixels[]: the pixels to update, in row-major order
 *
-* Expects: That array is not NULL
-**
-* Returns: None, but will update the given array to contain the pixels in the
-*               2x2 block at the given index. 
+* Expects: pixels holds BlockHeight * BlockWidth valid pixels
 *
-* Notes: Checked runtime error if array is NULL. Relies on the Decompress_CSBl-
-*               ock, cspace_to_rgb, and rgb_to_pixel functions to further
-*               steps of decompressing the pixels. e
+* Returns: None, but updates the given pixels
 *
 *********************************************************************/
-void setPixels(A2 array, A2Methods_T methods, int col, int row, 
-                        unsigned denominator, Compressed compressed)
+void decompress_pixels(Compressed compressed, unsigned denominator, 
+                       Pnm_rgb pixels[])
 {
-        assert(array != NULL);
         /* Extract lumas and averages from the code word */
         CSBlock cs_block = Decompress_CSBlock(compressed);
 
-        /* For each pixel in the block, decompress and add to array */
-        int i = 0;
-        for (int block_row = 0; block_row < BlockHeight; block_row++) {
-                for (int block_col = 0; block_col < BlockWidth; block_col++) {
-                        Vec3f rgb = cspace_to_rgb(cs_block[i]);
-                        Pnm_rgb pixel = methods->at(array, col + block_col, 
-                                        row + block_row);
-                        rgb_to_pixel(rgb, denominator, pixel);
-                        FREE(rgb);
-                        i++;
+        for (int i = 0; i < BlockHeight * BlockWidth; i++) {
+                Vec3f rgb = cspace_to_rgb(cs_block.pixels[i]);
+                rgb_to_pixel(rgb, denominator, pixels[i]);
+        }
+}
+
+/**************************** Block row kernels ****************************
+* getCompressedRow and setPixelsRow convert a whole row of 2x2 blocks at a 
+* time. Each vector lane holds one block, and every lane performs exactly the
+* same operations, in the same order, as the scalar functions above, so the 
+* results are bit-for-bit identical to calling compress_pixels or 
+* decompress_pixels on each block. SSE2 handles 2 blocks at a time and is 
+* always available on x86-64; AVX2 handles 4 and is picked at runtime when 
+* the CPU supports it. Any leftover blocks (and non-x86 builds) use the 
+* scalar functions.
+****************************************************************************/
+
+/* Pixel position within a block, in the row-major order of a CSBlock */
+static inline void block_pixels(struct Pnm_rgb *top, struct Pnm_rgb *bottom, 
+                                int block, Pnm_rgb pixels[])
+{
+        pixels[0] = &top[2 * block];
+        pixels[1] = &top[2 * block + 1];
+        pixels[2] = &bottom[2 * block];
+        pixels[3] = &bottom[2 * block + 1];
+}
+
+#if defined(__SSE2__)
+
+/* rgb[] = the channels of the pixel at pixels[0] and pixels[1], scaled */
+static inline void sse2_load_rgb(Pnm_rgb a, Pnm_rgb b, __m128d denom, 
+                                 __m128d rgb[3])
+{
+        rgb[RED] = _mm_div_pd(_mm_setr_pd(a->red, b->red), denom);
+        rgb[GREEN] = _mm_div_pd(_mm_setr_pd(a->green, b->green), denom);
+        rgb[BLUE] = _mm_div_pd(_mm_setr_pd(a->blue, b->blue), denom);
+}
+
+/* Lane-wise equivalent of MatfMultiply */
+static inline void sse2_multiply(floating (*mat)[], const __m128d *vec, 
+                                 __m128d *result, int size)
+{
+        floating (*matrix)[size] = mat;
+        for (int i = 0; i < size; i++) {
+                __m128d sum = _mm_setzero_pd();
+                for (int j = 0; j < size; j++) {
+                        sum = _mm_add_pd(sum, _mm_mul_pd(
+                                        _mm_set1_pd(matrix[i][j]), vec[j]));
                 }
+                result[i] = sum;
         }
-        deleteBlock(cs_block);
+}
 
+/* Lane-wise equivalent of scale_channel, for lanes that are known to fit */
+static inline __m128i sse2_scale(__m128d value, __m128d denom)
+{
+        __m128d scaled = _mm_mul_pd(value, denom);
+        scaled = _mm_min_pd(_mm_max_pd(scaled, _mm_setzero_pd()), denom);
+
+        /* round() is half away from zero: truncate, then bump up on .5 */
+        __m128d whole = _mm_cvtepi32_pd(_mm_cvttpd_epi32(scaled));
+        __m128d up = _mm_cmpge_pd(_mm_sub_pd(scaled, whole), 
+                                  _mm_set1_pd(0.5));
+        whole = _mm_add_pd(whole, _mm_and_pd(up, _mm_set1_pd(1.0)));
+        return _mm_cvttpd_epi32(whole);
+}
+
+static void sse2_compress_row(struct Pnm_rgb *top, struct Pnm_rgb *bottom, 
+                              int blocks, unsigned denominator, 
+                              Compressed *out)
+{
+        __m128d denom = _mm_set1_pd(denominator);
+        for (int k = 0; k + 2 <= blocks; k += 2) {
+                Pnm_rgb first[4], second[4];
+                block_pixels(top, bottom, k, first);
+                block_pixels(top, bottom, k + 1, second);
+
+                /* Color space for each pixel position of both blocks */
+                __m128d lumas[4];
+                __m128d total_pb = _mm_setzero_pd();
+                __m128d total_pr = _mm_setzero_pd();
+                for (int i = 0; i < BlockHeight * BlockWidth; i++) {
+                        __m128d rgb[3], cspace[3];
+                        sse2_load_rgb(first[i], second[i], denom, rgb);
+                        sse2_multiply(RGB_TO_COLORSPACE, rgb, cspace, 3);
+                        lumas[i] = cspace[LUMA];
+                        total_pb = _mm_add_pd(total_pb, cspace[PB]);
+                        total_pr = _mm_add_pd(total_pr, cspace[PR]);
+                }
+
+                __m128d dct[4];
+                sse2_multiply(LUMAS_TO_DCT, lumas, dct, 4);
+                __m128d count = _mm_set1_pd(BlockHeight * BlockWidth);
+                __m128d avg_pb = _mm_div_pd(total_pb, count);
+                __m128d avg_pr = _mm_div_pd(total_pr, count);
+
+                for (int i = 0; i < 4; i++) {
+                        _mm_storel_pd(&out[k].dct_coeffs.v[i], dct[i]);
+                        _mm_storeh_pd(&out[k + 1].dct_coeffs.v[i], dct[i]);
+                }
+                _mm_storel_pd(&out[k].avg_pb, avg_pb);
+                _mm_storeh_pd(&out[k + 1].avg_pb, avg_pb);
+                _mm_storel_pd(&out[k].avg_pr, avg_pr);
+                _mm_storeh_pd(&out[k + 1].avg_pr, avg_pr);
+        }
+}
+
+static void sse2_decompress_row(const Compressed *in, int blocks, 
+                                unsigned denominator, struct Pnm_rgb *top, 
+                                struct Pnm_rgb *bottom)
+{
+        __m128d denom = _mm_set1_pd(denominator);
+        for (int k = 0; k + 2 <= blocks; k += 2) {
+                __m128d dct[4], lumas[4];
+                for (int i = 0; i < 4; i++) {
+                        dct[i] = _mm_setr_pd(in[k].dct_coeffs.v[i], 
+                                             in[k + 1].dct_coeffs.v[i]);
+                }
+                sse2_multiply(DCT_TO_LUMAS, dct, lumas, 4);
+                __m128d pb = _mm_setr_pd(in[k].avg_pb, in[k + 1].avg_pb);
+                __m128d pr = _mm_setr_pd(in[k].avg_pr, in[k + 1].avg_pr);
+
+                Pnm_rgb first[4], second[4];
+                block_pixels(top, bottom, k, first);
+                block_pixels(top, bottom, k + 1, second);
+                for (int i = 0; i < BlockHeight * BlockWidth; i++) {
+                        __m128d cspace[3] = { lumas[i], pb, pr };
+                        __m128d rgb[3];
+                        unsigned scaled[3][4];
+                        sse2_multiply(COLORSPACE_TO_RGB, cspace, rgb, 3);
+                        for (int c = 0; c < 3; c++) {
+                                _mm_storeu_si128((__m128i *) scaled[c], 
+                                                 sse2_scale(rgb[c], denom));
+                        }
+                        first[i]->red = scaled[RED][0];
+                        first[i]->green = scaled[GREEN][0];
+                        first[i]->blue = scaled[BLUE][0];
+                        second[i]->red = scaled[RED][1];
+                        second[i]->green = scaled[GREEN][1];
+                        second[i]->blue = scaled[BLUE][1];
+                }
+        }
+}
+
+static void sse2_thumbnail_row(const int32_t *a, const floating *pb, 
+                               const floating *pr, int blocks, 
+                               unsigned denominator, struct Pnm_rgb *row)
+{
+        __m128d denom = _mm_set1_pd(denominator);
+        __m128d levels = _mm_set1_pd(63.0);
+        for (int k = 0; k + 2 <= blocks; k += 2) {
+                __m128d cspace[3], rgb[3];
+                __m128i a_pair = _mm_loadl_epi64((const __m128i *) (a + k));
+                cspace[LUMA] = _mm_div_pd(_mm_cvtepi32_pd(a_pair), levels);
+                cspace[PB] = _mm_loadu_pd(pb + k);
+                cspace[PR] = _mm_loadu_pd(pr + k);
+                sse2_multiply(COLORSPACE_TO_RGB, cspace, rgb, 3);
+                unsigned scaled[3][4];
+                for (int c = 0; c < 3; c++) {
+                        _mm_storeu_si128((__m128i *) scaled[c], 
+                                         sse2_scale(rgb[c], denom));
+                }
+                for (int lane = 0; lane < 2; lane++) {
+                        row[k + lane].red = scaled[RED][lane];
+                        row[k + lane].green = scaled[GREEN][lane];
+                        row[k + lane].blue = scaled[BLUE][lane];
+                }
+        }
+}
+
+#endif /* __SSE2__ */
+
+#if defined(__GNUC__) && defined(__x86_64__)
+#define AVX2 __attribute__((target("avx2")))
+
+/* Gathers one channel of the pixels at the same position in 4 blocks */
+AVX2 static inline __m256d avx2_load_channel(const unsigned *channel, 
+                                             __m256d denom)
+{
+        const int stride = 2 * sizeof(struct Pnm_rgb) / sizeof(unsigned);
+        __m128i index = _mm_setr_epi32(0, stride, 2 * stride, 3 * stride);
+        __m128i values = _mm_i32gather_epi32((const int *) channel, index, 
+                                             sizeof(unsigned));
+        return _mm256_div_pd(_mm256_cvtepi32_pd(values), denom);
+}
+
+/* Gathers one double field from 4 consecutive Compressed blocks */
+AVX2 static inline __m256d avx2_load_field(const floating *field)
+{
+        const int stride = sizeof(Compressed) / sizeof(floating);
+        __m128i index = _mm_setr_epi32(0, stride, 2 * stride, 3 * stride);
+        return _mm256_i32gather_pd(field, index, sizeof(floating));
+}
+
+/* Lane-wise equivalent of MatfMultiply */
+AVX2 static inline void avx2_multiply(floating (*mat)[], const __m256d *vec, 
+                                      __m256d *result, int size)
+{
+        floating (*matrix)[size] = mat;
+        for (int i = 0; i < size; i++) {
+                __m256d sum = _mm256_setzero_pd();
+                for (int j = 0; j < size; j++) {
+                        sum = _mm256_add_pd(sum, _mm256_mul_pd(
+                                        _mm256_set1_pd(matrix[i][j]), vec[j]));
+                }
+                result[i] = sum;
+        }
+}
+
+/* Lane-wise equivalent of scale_channel */
+AVX2 static inline __m128i avx2_scale(__m256d value, __m256d denom)
+{
+        __m256d scaled = _mm256_mul_pd(value, denom);
+        scaled = _mm256_min_pd(_mm256_max_pd(scaled, _mm256_setzero_pd()), 
+                               denom);
+        __m256d whole = _mm256_round_pd(scaled, _MM_FROUND_TO_ZERO | 
+                                                _MM_FROUND_NO_EXC);
+        __m256d up = _mm256_cmp_pd(_mm256_sub_pd(scaled, whole), 
+                                   _mm256_set1_pd(0.5), _CMP_GE_OQ);
+        whole = _mm256_add_pd(whole, _mm256_and_pd(up, _mm256_set1_pd(1.0)));
+        return _mm256_cvttpd_epi32(whole);
+}
+
+AVX2 static void avx2_compress_row(struct Pnm_rgb *top, struct Pnm_rgb *bottom,
+                                   int blocks, unsigned denominator, 
+                                   Compressed *out)
+{
+        __m256d denom = _mm256_set1_pd(denominator);
+        for (int k = 0; k + 4 <= blocks; k += 4) {
+                Pnm_rgb pixels[4];
+                block_pixels(top, bottom, k, pixels);
+
+                __m256d lumas[4];
+                __m256d total_pb = _mm256_setzero_pd();
+                __m256d total_pr = _mm256_setzero_pd();
+                for (int i = 0; i < BlockHeight * BlockWidth; i++) {
+                        __m256d rgb[3], cspace[3];
+                        rgb[RED] = avx2_load_channel(&pixels[i]->red, denom);
+                        rgb[GREEN] = avx2_load_channel(&pixels[i]->green, 
+                                                       denom);
+                        rgb[BLUE] = avx2_load_channel(&pixels[i]->blue, denom);
+                        avx2_multiply(RGB_TO_COLORSPACE, rgb, cspace, 3);
+                        lumas[i] = cspace[LUMA];
+                        total_pb = _mm256_add_pd(total_pb, cspace[PB]);
+                        total_pr = _mm256_add_pd(total_pr, cspace[PR]);
+                }
+
+                __m256d dct[4];
+                avx2_multiply(LUMAS_TO_DCT, lumas, dct, 4);
+                __m256d count = _mm256_set1_pd(BlockHeight * BlockWidth);
+                floating fields[6][4];
+                for (int i = 0; i < 4; i++) {
+                        _mm256_storeu_pd(fields[i], dct[i]);
+                }
+                _mm256_storeu_pd(fields[4], _mm256_div_pd(total_pb, count));
+                _mm256_storeu_pd(fields[5], _mm256_div_pd(total_pr, count));
+
+                for (int lane = 0; lane < 4; lane++) {
+                        for (int i = 0; i < 4; i++) {
+                                out[k + lane].dct_coeffs.v[i] = fields[i][lane];
+                        }
+                        out[k + lane].avg_pb = fields[4][lane];
+                        out[k + lane].avg_pr = fields[5][lane];
+                }
+        }
+}
+
+AVX2 static void avx2_decompress_row(const Compressed *in, int blocks, 
+                                     unsigned denominator, 
+                                     struct Pnm_rgb *top, 
+                                     struct Pnm_rgb *bottom)
+{
+        __m256d denom = _mm256_set1_pd(denominator);
+        for (int k = 0; k + 4 <= blocks; k += 4) {
+                __m256d dct[4], lumas[4];
+                for (int i = 0; i < 4; i++) {
+                        dct[i] = avx2_load_field(&in[k].dct_coeffs.v[i]);
+                }
+                avx2_multiply(DCT_TO_LUMAS, dct, lumas, 4);
+                __m256d pb = avx2_load_field(&in[k].avg_pb);
+                __m256d pr = avx2_load_field(&in[k].avg_pr);
+
+                for (int i = 0; i < BlockHeight * BlockWidth; i++) {
+                        __m256d cspace[3] = { lumas[i], pb, pr };
+                        __m256d rgb[3];
+                        unsigned scaled[3][4];
+                        avx2_multiply(COLORSPACE_TO_RGB, cspace, rgb, 3);
+                        for (int c = 0; c < 3; c++) {
+                                _mm_storeu_si128((__m128i *) scaled[c], 
+                                                 avx2_scale(rgb[c], denom));
+                        }
+                        for (int lane = 0; lane < 4; lane++) {
+                                Pnm_rgb pixels[4];
+                                block_pixels(top, bottom, k + lane, pixels);
+                                pixels[i]->red = scaled[RED][lane];
+                                pixels[i]->green = scaled[GREEN][lane];
+                                pixels[i]->blue = scaled[BLUE][lane];
+                        }
+                }
+        }
+}
+
+AVX2 static void avx2_thumbnail_row(const int32_t *a, const floating *pb, 
+                                    const floating *pr, int blocks, 
+                                    unsigned denominator, struct Pnm_rgb *row)
+{
+        __m256d denom = _mm256_set1_pd(denominator);
+        __m256d levels = _mm256_set1_pd(63.0);
+        for (int k = 0; k + 4 <= blocks; k += 4) {
+                __m256d cspace[3], rgb[3];
+                __m128i a_quad = _mm_loadu_si128((const __m128i *) (a + k));
+                cspace[LUMA] = _mm256_div_pd(_mm256_cvtepi32_pd(a_quad), 
+                                             levels);
+                cspace[PB] = _mm256_loadu_pd(pb + k);
+                cspace[PR] = _mm256_loadu_pd(pr + k);
+                avx2_multiply(COLORSPACE_TO_RGB, cspace, rgb, 3);
+                unsigned scaled[3][4];
+                for (int c = 0; c < 3; c++) {
+                        _mm_storeu_si128((__m128i *) scaled[c], 
+                                         avx2_scale(rgb[c], denom));
+                }
+                for (int lane = 0; lane < 4; lane++) {
+                        row[k + lane].red = scaled[RED][lane];
+                        row[k + lane].green = scaled[GREEN][lane];
+                        row[k + lane].blue = scaled[BLUE][lane];
+                }
+        }
+}
+
+#undef AVX2
+#define HAVE_AVX2_KERNELS 1
+#endif
+
+/***************************getCompressedRow*********************************
+*
+* Converts a whole row of 2x2 blocks, given as the two pixel rows it covers,
+* into Compressed values.
+*
+* Parameters: struct Pnm_rgb *top: the first pixel row of the block row
+*             struct Pnm_rgb *bottom: the second pixel row of the block row
+*             int blocks: the number of blocks in the row
+*             unsigned denominator: the denominator of the image
+*             Compressed *out: where to store the Compressed block values
+*
+* Expects: top and bottom each hold at least 2 * blocks contiguous pixels, 
+*          and out has room for blocks values. Denominator is non-zero.
+*
+* Returns: None, but out[i] holds the same value compress_pixels would give 
+*          for block i.
+*
+*********************************************************************/
+void getCompressedRow(struct Pnm_rgb *top, struct Pnm_rgb *bottom, int blocks,
+                      unsigned denominator, Compressed *out)
+{
+        assert(top != NULL && bottom != NULL && out != NULL);
+        int done = 0;
+#if defined(HAVE_AVX2_KERNELS)
+        if (__builtin_cpu_supports("avx2")) {
+                avx2_compress_row(top, bottom, blocks, denominator, out);
+                done = blocks - blocks % 4;
+        }
+#endif
+#if defined(__SSE2__)
+        if (done == 0) {
+                sse2_compress_row(top, bottom, blocks, denominator, out);
+                done = blocks - blocks % 2;
+        }
+#endif
+        for (int k = done; k < blocks; k++) {
+                Pnm_rgb pixels[BlockHeight * BlockWidth];
+                block_pixels(top, bottom, k, pixels);
+                out[k] = compress_pixels(pixels, denominator);
+        }
+}
+
+/***************************setPixelsRow*********************************
+*
+* Converts a row of Compressed values back into the two pixel rows they 
+* cover.
+*
+* Parameters: const Compressed *in: the Compressed values of the block row
+*             int blocks: the number of blocks in the row
+*             unsigned denominator: the denominator for the decompressed image
+*             struct Pnm_rgb *top: the first pixel row of the block row
+*             struct Pnm_rgb *bottom: the second pixel row of the block row
+*
+* Expects: top and bottom each hold at least 2 * blocks contiguous pixels, 
+*          and in holds blocks values. Denominator is non-zero.
+*
+* Returns: None, but updates the pixels exactly as decompress_pixels would.
+*
+*********************************************************************/
+void setPixelsRow(const Compressed *in, int blocks, unsigned denominator, 
+                  struct Pnm_rgb *top, struct Pnm_rgb *bottom)
+{
+        assert(top != NULL && bottom != NULL && in != NULL);
+        int done = 0;
+#if defined(HAVE_AVX2_KERNELS)
+        if (__builtin_cpu_supports("avx2")) {
+                avx2_decompress_row(in, blocks, denominator, top, bottom);
+                done = blocks - blocks % 4;
+        }
+#endif
+#if defined(__SSE2__)
+        if (done == 0) {
+                sse2_decompress_row(in, blocks, denominator, top, bottom);
+                done = blocks - blocks % 2;
+        }
+#endif
+        for (int k = done; k < blocks; k++) {
+                Pnm_rgb pixels[BlockHeight * BlockWidth];
+                block_pixels(top, bottom, k, pixels);
+                decompress_pixels(in[k], denominator, pixels);
+        }
+}
+
+/***************************setThumbnailRow*********************************
+*
+* Converts a row of code words into one pixel per block, from the average 
+* luma and chroma of each block alone
+*
+* Parameters: struct Codeword_row fields: the fields of each code word
+*             int count: the number of code words
+*             unsigned denominator: the denominator for the thumbnail
+*             struct Pnm_rgb *row: where to store the pixels
+*
+* Expects: row has room for count pixels, which is a checked runtime error if
+*          it is NULL. Denominator is non-zero.
+*
+* Returns: None
+*
+* Notes: Each pixel is what decompress_pixels would give all four pixels of 
+*        a block whose b, c and d are 0, so the inverse DCT is skipped, and 
+*        only the a, pb_bar and pr_bar fields are read. The chroma values
+*        of up to THUMBNAIL_CHUNK blocks at a time are looked up into arrays
+*        on the stack, and then converted with the same kernels as 
+*        setPixelsRow.
+*********************************************************************/
+void setThumbnailRow(struct Codeword_row fields, int count, 
+                     unsigned denominator, struct Pnm_rgb *row)
+{
+        assert(row != NULL);
+        floating pb[THUMBNAIL_CHUNK], pr[THUMBNAIL_CHUNK];
+        for (int first = 0; first < count; first += THUMBNAIL_CHUNK) {
+                int blocks = count - first < THUMBNAIL_CHUNK ? 
+                             count - first : THUMBNAIL_CHUNK;
+                const int32_t *a = fields.a + first;
+                struct Pnm_rgb *pixels = row + first;
+                Chroma_value_row(fields.pb_bar + first, blocks, pb, 1);
+                Chroma_value_row(fields.pr_bar + first, blocks, pr, 1);
+                int done = 0;
+#if defined(HAVE_AVX2_KERNELS)
+                if (__builtin_cpu_supports("avx2")) {
+                        avx2_thumbnail_row(a, pb, pr, blocks, denominator, 
+                                           pixels);
+                        done = blocks - blocks % 4;
+                }
+#endif
+#if defined(__SSE2__)
+                if (done == 0) {
+                        sse2_thumbnail_row(a, pb, pr, blocks, denominator, 
+                                           pixels);
+                        done = blocks - blocks % 2;
+                }
+#endif
+                for (int k = done; k < blocks; k++) {
+                        Vec3f cspace;
+                        cspace.v[LUMA] = a[k] / 63.0;
+                        cspace.v[PB] = pb[k];
+                        cspace.v[PR] = pr[k];
+                        rgb_to_pixel(cspace_to_rgb(cspace), denominator, 
+                                     &pixels[k]);
+                }
+        }
+}
+
+/*****************************quantize_row**********************************
+*
+* Quantizes the values of a row of blocks into the fields of their code words
+*
+* Parameters: const Compressed *blocks: the values of each block
+*             int count: the number of blocks
+*             struct Codeword_row fields: where to store the fields
+*
+* Expects: every array of fields has room for count values
+*
+* Return: nothing
+*
+* Notes: relies on the chroma interface to create the indices for the chroma,
+*        and the scale_DCT function to scale the DCT coefficients. The values
+*        are known to fit their fields: a is at most 63, b, c and d are 
+*        clamped to [-31, 31], and the chroma indices are below 16.
+*
+*********************************************************************/
+void quantize_row(const Compressed *blocks, int count, 
+                  struct Codeword_row fields)
+{
+        /* Create indices for chroma, a whole row at a time */
+        long stride = sizeof(*blocks) / sizeof(floating);
+        Chroma_index_row(&blocks[0].avg_pb, stride, count, fields.pb_bar);
+        Chroma_index_row(&blocks[0].avg_pr, stride, count, fields.pr_bar);
+
+        for (int i = 0; i < count; i++) {
+                /* Scale coefficients to discrete cosine */
+                const floating *dct_coeffs = blocks[i].dct_coeffs.v;
+                fields.a[i] = round(dct_coeffs[0] * 63.0);
+                fields.b[i] = scale_DCT(dct_coeffs[1]);
+                fields.c[i] = scale_DCT(dct_coeffs[2]);
+                fields.d[i] = scale_DCT(dct_coeffs[3]);
+        }
+}
+
+/*****************************scale_DCT**********************************
+*
+* Converts the given coefficient to a DCT value
+*
+* Parameters: double coefficient: the coefficient for a particular pixel 
+*
+* Expects: None
+*
+* Return: an integer containing the scaled value of the coefficient  
+*
+*********************************************************************/
+int scale_DCT(double coefficient)
+{
+        /* If coefficient is range, set it to 0.3 or -0.3*/
+        if (coefficient > 0.3) {
+                coefficient = 0.3;
+        }
+
+        else if (coefficient < -0.3) {
+                coefficient = -0.3;
+        }
+
+        /* Scale coefficient and return */
+        double scaled = coefficient * 103.33;
+        
+        return round(scaled);
+}
+
+/*****************************dequantize_row********************************
+*
+* Converts the fields of a row of code words back into the values of their 
+* blocks, unscaling the DCT values and converting the indices back to chroma
+*
+* Parameters: struct Codeword_row fields: the fields of each code word
+*             int count: the number of code words
+*             Compressed *blocks: where to store the values of each block
+*
+* Expects: every array of fields holds count values, and blocks has room for
+*          count values
+*
+* Return: nothing
+*
+* Notes: Relies on the chroma interface to get the average chroma from the 
+*        indices
+*
+*********************************************************************/
+void dequantize_row(struct Codeword_row fields, int count, Compressed *blocks)
+{
+        for (int i = 0; i < count; i++) {
+                Vec4f *dct_coeffs = &blocks[i].dct_coeffs;
+                dct_coeffs->v[0] = fields.a[i] / 63.0;
+                dct_coeffs->v[1] = unscale_DCT(fields.b[i]);
+                dct_coeffs->v[2] = unscale_DCT(fields.c[i]);
+                dct_coeffs->v[3] = unscale_DCT(fields.d[i]);
+        }
+
+        long stride = sizeof(*blocks) / sizeof(floating);
+        Chroma_value_row(fields.pb_bar, count, &blocks[0].avg_pb, stride);
+        Chroma_value_row(fields.pr_bar, count, &blocks[0].avg_pr, stride);
+}
+
+/*****************************unscale_DCT**********************************
+*
+* Reverses the scaling of the DCT value 
+*
+* Parameters: int scaled: a scale DCT value to scale back down
+*
+* Expects: None
+*
+* Return: a double containing the unscaled coefficient of the DCT
+*
+*********************************************************************/
+double unscale_DCT(int scaled) 
+{
+        /* Unscale value and return */
+        return ((double) scaled / 103.33);
 }
 
-#undef A2
+#undef HAVE_AVX2_KERNELS
 #undef BlockWidth
 #undef BlockHeight
+#undef THUMBNAIL_CHUNK
 #undef RED
 #undef GREEN
 #undef BLUE
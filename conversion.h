@@ -4,10 +4,9 @@
  *
  *     Functions for converting 2x2 blocks of RGB pixels to DCT values and 
  *     averages, as well as converting DCT values and averages to RGB pixels. 
- *     Relies on the UArray2 interface and a2plain methods suite to get pixels
- *     to compress or store pixels once they are decompressed. Called by
- *     compress40 to handle the calculations behind compressing and decompress-
- *     ing pixels. 
+ *     Works on whole rows of blocks, straight from and to the two rows of 
+ *     pixels they cover. Called by compress40 to handle the calculations 
+ *     behind compressing and decompressing pixels. 
  *
  */
 
@@ -17,22 +16,27 @@
 #include "assert.h"
 #include "except.h"
 #include "pnm.h"
-#include "a2plain.h"
 #include "mem.h"
-#define A2 A2Methods_UArray2
+#include "codeword.h"
 
 /* typedefs
-* Floating is a floating point number, Vecf is a vector of floating point 
-* numbers. Vec3f and Vec4f represent vectors of 3 and 4 numbers respectively.
+* Floating is a floating point number. Vec3f and Vec4f are fixed size vectors
+* of 3 and 4 numbers respectively, and are passed around by value so that no
+* block of the image ever needs its own heap allocation.
 * CSBlock, short for ColorSpaceBlock, is a block of Vec3f's each of
 which represents a color space representation of a pixel. Our implementation 
-uses a 2by2 block.
+uses a 2by2 block, stored in row-major order.
 */
 typedef double floating;
-typedef floating *Vecf;
-typedef floating *Vec3f;
-typedef floating *Vec4f;
-typedef Vec3f *CSBlock;
+typedef struct Vec3f {
+        floating v[3];
+} Vec3f;
+typedef struct Vec4f {
+        floating v[4];
+} Vec4f;
+typedef struct CSBlock {
+        Vec3f pixels[4];
+} CSBlock;
 
 /* struct Compressed - Contains the compressed representation of a CSBlock
 * dct_coeffs - A Vec4f of the "a, b, c, d" values produced by the discrete 
@@ -49,11 +53,26 @@ typedef struct Compressed {
 
 
 
-Vecf vec_new(unsigned size);
-void setPixels(A2 array, A2Methods_T methods, int col, int row, 
-                        unsigned denominator, Compressed compressed);
+/* Convert a whole row of 2x2 blocks to their Compressed values, and back. 
+ * top and bottom are the two pixel rows covered by the blocks, each stored
+ * contiguously. */
+void getCompressedRow(struct Pnm_rgb *top, struct Pnm_rgb *bottom, int blocks,
+                      unsigned denominator, Compressed *out);
 
-Compressed getCompressed(A2 array, A2Methods_T methods, int col, int row, 
-                        unsigned denominator);
+void setPixelsRow(const Compressed *in, int blocks, unsigned denominator, 
+                  struct Pnm_rgb *top, struct Pnm_rgb *bottom);
 
-#undef A2
\ No newline at end of file
+/* Converts the a, pb_bar and pr_bar fields of count code words, the average
+ * luma and chroma of their blocks, into one pixel per block */
+void setThumbnailRow(struct Codeword_row fields, int count, 
+                     unsigned denominator, struct Pnm_rgb *row);
+
+/* Quantizes the values of count blocks into the fields of their code words,
+ * and back */
+void quantize_row(const Compressed *blocks, int count, 
+                  struct Codeword_row fields);
+void dequantize_row(struct Codeword_row fields, int count, Compressed *blocks);
+
+/* Scales a DCT coefficient to a 6-bit signed field, and back */
+int scale_DCT(double coefficient);
+double unscale_DCT(int scaled);
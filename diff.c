@@ -0,0 +1,132 @@
+/*
+ *     diff.c
+ *     by Abhinav Mummameni (amumma01) and Rolando Ortega (rorteg02)
+ *
+ *     Implementation of the diff interface. The sum is kept in DIFF_LANES
+ *     partial sums, and value i is always added to partial sum i %
+ *     DIFF_LANES, whether it goes through AVX2 (all 4 sums in one register),
+ *     SSE2 (2 sums in each of two registers) or the scalar loop. Each
+ *     partial sum therefore sees the same operations in the same order on
+ *     every path, and the partial sums are added together in a fixed order
+ *     at the end.
+ */
+
+#include <stdlib.h>
+#include "assert.h"
+#include "diff.h"
+#if defined(__GNUC__) && defined(__x86_64__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#define DIFF_LANES 4
+
+/* Adds values [first, n) to their partial sums one at a time */
+static void scalar_squares(const unsigned *a, const unsigned *b, long first,
+                           long n, double scale_a, double scale_b,
+                           double sums[DIFF_LANES])
+{
+        for (long i = first; i < n; i++) {
+                double diff = a[i] * scale_a - b[i] * scale_b;
+                sums[i % DIFF_LANES] += diff * diff;
+        }
+}
+
+#if defined(__SSE2__)
+
+/* Values below 2^31 convert exactly as signed 32-bit integers */
+static long sse2_squares(const unsigned *a, const unsigned *b, long n,
+                         double scale_a, double scale_b,
+                         double sums[DIFF_LANES])
+{
+        __m128d low = _mm_loadu_pd(sums), high = _mm_loadu_pd(sums + 2);
+        __m128d sa = _mm_set1_pd(scale_a), sb = _mm_set1_pd(scale_b);
+        long i;
+        for (i = 0; i + DIFF_LANES <= n; i += DIFF_LANES) {
+                __m128i va = _mm_loadu_si128((const __m128i *) (a + i));
+                __m128i vb = _mm_loadu_si128((const __m128i *) (b + i));
+                __m128d diff = _mm_sub_pd(
+                        _mm_mul_pd(_mm_cvtepi32_pd(va), sa),
+                        _mm_mul_pd(_mm_cvtepi32_pd(vb), sb));
+                low = _mm_add_pd(low, _mm_mul_pd(diff, diff));
+                diff = _mm_sub_pd(
+                        _mm_mul_pd(_mm_cvtepi32_pd(
+                                _mm_unpackhi_epi64(va, va)), sa),
+                        _mm_mul_pd(_mm_cvtepi32_pd(
+                                _mm_unpackhi_epi64(vb, vb)), sb));
+                high = _mm_add_pd(high, _mm_mul_pd(diff, diff));
+        }
+        _mm_storeu_pd(sums, low);
+        _mm_storeu_pd(sums + 2, high);
+        return i;
+}
+
+#endif /* __SSE2__ */
+
+#if defined(__GNUC__) && defined(__x86_64__)
+#define AVX2 __attribute__((target("avx2")))
+
+AVX2 static long avx2_squares(const unsigned *a, const unsigned *b, long n,
+                              double scale_a, double scale_b,
+                              double sums[DIFF_LANES])
+{
+        __m256d sum = _mm256_loadu_pd(sums);
+        __m256d sa = _mm256_set1_pd(scale_a), sb = _mm256_set1_pd(scale_b);
+        long i;
+        for (i = 0; i + DIFF_LANES <= n; i += DIFF_LANES) {
+                __m256d diff = _mm256_sub_pd(
+                        _mm256_mul_pd(_mm256_cvtepi32_pd(_mm_loadu_si128(
+                                (const __m128i *) (a + i))), sa),
+                        _mm256_mul_pd(_mm256_cvtepi32_pd(_mm_loadu_si128(
+                                (const __m128i *) (b + i))), sb));
+                sum = _mm256_add_pd(sum, _mm256_mul_pd(diff, diff));
+        }
+        _mm256_storeu_pd(sums, sum);
+        return i;
+}
+
+#undef AVX2
+#define HAVE_AVX2_KERNELS 1
+#endif
+
+/***************************Diff_squares**********************************
+*
+* Sums the squared differences between two arrays of scaled values
+*
+* Parameters: const unsigned *a, *b: the values to compare
+*             long n: the number of values in each array
+*             double scale_a, scale_b: what to multiply each array's values
+*                                      by before they are compared, usually
+*                                      1 / denominator
+*
+* Expects: a and b are not NULL and n is not negative, which are checked
+*          runtime errors, and every value is below 2^31
+*
+* Return: the sum over i < n of (a[i] * scale_a - b[i] * scale_b)^2
+*
+* Notes: the result depends only on the values, not on the CPU's vector
+*        instructions; see the top of this file
+*********************************************************************/
+double Diff_squares(const unsigned *a, const unsigned *b, long n,
+                    double scale_a, double scale_b)
+{
+        assert(a != NULL && b != NULL && n >= 0);
+        double sums[DIFF_LANES] = { 0.0, 0.0, 0.0, 0.0 };
+        long done = 0;
+#if defined(HAVE_AVX2_KERNELS)
+        if (__builtin_cpu_supports("avx2")) {
+                done = avx2_squares(a, b, n, scale_a, scale_b, sums);
+        }
+#endif
+#if defined(__SSE2__)
+        if (done == 0) {
+                done = sse2_squares(a, b, n, scale_a, scale_b, sums);
+        }
+#endif
+        scalar_squares(a, b, done, n, scale_a, scale_b, sums);
+        return (sums[0] + sums[1]) + (sums[2] + sums[3]);
+}
+
+#undef HAVE_AVX2_KERNELS
+#undef DIFF_LANES
@@ -0,0 +1,20 @@
+/*
+ *     diff.h
+ *     by Abhinav Mummameni (amumma01) and Rolando Ortega (rorteg02)
+ *
+ *     Interface for the squared differences behind ppmdiff's error. Rows of
+ *     pixels are treated as flat arrays of channel values, since every
+ *     channel counts the same, and are summed several values at a time with
+ *     SIMD. The order of the additions is fixed, whichever instruction set
+ *     is used, so the same rows always give exactly the same sum.
+ */
+
+#ifndef DIFF_INCLUDED
+#define DIFF_INCLUDED
+
+/* Returns the sum over i < n of (a[i] * scale_a - b[i] * scale_b)^2. Each
+ * value must be below 2^31. */
+extern double Diff_squares(const unsigned *a, const unsigned *b, long n,
+                           double scale_a, double scale_b);
+
+#endif
@@ -0,0 +1,410 @@
+/*
+ *     entropy.c
+ *     by Abhinav Mummameni (amumma01) and Rolando Ortega (rorteg02)
+ *
+ *     Implementation of the entropy interface. A coded tile holds, for each
+ *     field of CODEWORD_FIELDS in order:
+ *
+ *         the code length of each of the 2^width symbols, 4 bits each, two
+ *             to a byte with the first symbol in the high bits
+ *         the number of bytes of coded symbols, 4 bytes big endian
+ *         the canonical Huffman code of each symbol, most significant bit
+ *             first, padded with 0 bits to a whole byte
+ *
+ *     A symbol is the bits a field takes up in a code word. Unsigned fields
+ *     (a, pb_bar and pr_bar) are coded as their difference, modulo 2^width,
+ *     from the block to the left, or from the block above for the first
+ *     block of a row, or from 0 for the first block of the tile. Codes are
+ *     never longer than MAX_CODE_BITS, so the decoder finds each symbol with
+ *     one lookup in a table of 2^MAX_CODE_BITS entries.
+ */
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include "assert.h"
+#include "except.h"
+#include "texcept.h"
+#include "mem.h"
+#include "codeword.h"
+#include "entropy.h"
+
+#define MAX_CODE_BITS 12
+#define MAX_SYMBOLS 64
+
+Except_T Entropy_Corrupt = { "Entropy coded tile is corrupt" };
+
+/* The width of each field, and whether it is predicted from its neighbors */
+#define FIELD_WIDTH(name, width, lsb, sign) width,
+static const int widths[CODEWORD_NFIELDS] = { CODEWORD_FIELDS(FIELD_WIDTH) };
+#undef FIELD_WIDTH
+
+#define PREDICTED_UNSIGNED 1
+#define PREDICTED_SIGNED 0
+#define FIELD_PREDICTED(name, width, lsb, sign) PREDICTED_##sign,
+static const int predicted[CODEWORD_NFIELDS] = {
+        CODEWORD_FIELDS(FIELD_PREDICTED)
+};
+#undef FIELD_PREDICTED
+
+/* Every field must have at most MAX_SYMBOLS symbols */
+#define FIELD_FITS(name, width, lsb, sign) && (1 << (width)) <= MAX_SYMBOLS
+typedef char Entropy_fields_fit[(1 CODEWORD_FIELDS(FIELD_FITS)) ? 1 : -1];
+#undef FIELD_FITS
+
+/* struct Output - A growing array of bytes */
+struct Output {
+        unsigned char *bytes;
+        long length;
+        long capacity;
+};
+
+static void put_byte(struct Output *out, unsigned char byte)
+{
+        if (out->length == out->capacity) {
+                out->capacity *= 2;
+                RESIZE(out->bytes, out->capacity);
+        }
+        out->bytes[out->length++] = byte;
+}
+
+/* The prediction of value i of a width-wide tile, from values before it */
+static inline int32_t prediction(const int32_t *values, long i, int width)
+{
+        if (i % width != 0) {
+                return values[i - 1];
+        }
+        return i >= width ? values[i - width] : 0;
+}
+
+/***************************huffman_lengths*********************************
+*
+* Finds the length of the Huffman code of each symbol
+*
+* Parameters: const long *weights: how often each symbol occurs
+*             int n: the number of symbols
+*             unsigned char *lengths: where to store the code lengths
+*
+* Return: nothing, but symbols that never occur get a length of 0, and a
+*         lone symbol gets a length of 1
+*
+* Notes: merges the two lightest trees until one is left; with at most
+*        MAX_SYMBOLS symbols, a linear search for them is fast enough
+*********************************************************************/
+static void huffman_lengths(const long *weights, int n,
+                            unsigned char *lengths)
+{
+        long weight[2 * MAX_SYMBOLS];
+        int parent[2 * MAX_SYMBOLS], symbol[MAX_SYMBOLS];
+        int nodes = 0;
+        for (int s = 0; s < n; s++) {
+                lengths[s] = 0;
+                if (weights[s] > 0) {
+                        weight[nodes] = weights[s];
+                        parent[nodes] = -1;
+                        symbol[nodes++] = s;
+                }
+        }
+        if (nodes == 1) {
+                lengths[symbol[0]] = 1;
+                return;
+        }
+
+        int leaves = nodes;
+        for (int live = leaves; live > 1; live--) {
+                int first = -1, second = -1;
+                for (int i = 0; i < nodes; i++) {
+                        if (parent[i] != -1) {
+                                continue;
+                        }
+                        if (first == -1 || weight[i] < weight[first]) {
+                                second = first;
+                                first = i;
+                        } else if (second == -1 ||
+                                   weight[i] < weight[second]) {
+                                second = i;
+                        }
+                }
+                weight[nodes] = weight[first] + weight[second];
+                parent[nodes] = -1;
+                parent[first] = parent[second] = nodes++;
+        }
+        for (int i = 0; i < leaves; i++) {
+                int depth = 0;
+                for (int node = i; parent[node] != -1; node = parent[node]) {
+                        depth++;
+                }
+                lengths[symbol[i]] = depth;
+        }
+}
+
+/* Finds code lengths of at most MAX_CODE_BITS, by halving the weights until
+ * the Huffman code is short enough. No weight ever drops to 0. */
+static void code_lengths(const long *counts, int n, unsigned char *lengths)
+{
+        long weights[MAX_SYMBOLS];
+        memcpy(weights, counts, n * sizeof(*weights));
+        for (;;) {
+                huffman_lengths(weights, n, lengths);
+                int longest = 0;
+                for (int s = 0; s < n; s++) {
+                        longest = lengths[s] > longest ? lengths[s] : longest;
+                }
+                if (longest <= MAX_CODE_BITS) {
+                        return;
+                }
+                for (int s = 0; s < n; s++) {
+                        weights[s] = (weights[s] + 1) / 2;
+                }
+        }
+}
+
+/* Assigns canonical codes: shorter codes first, and codes of the same
+ * length in symbol order. Returns 0 if the lengths are too long or
+ * over-subscribe the code space. */
+static int canonical_codes(const unsigned char *lengths, int n,
+                           uint32_t *codes)
+{
+        int count[MAX_CODE_BITS + 1] = { 0 };
+        for (int s = 0; s < n; s++) {
+                if (lengths[s] > MAX_CODE_BITS) {
+                        return 0;
+                }
+                count[lengths[s]]++;
+        }
+        count[0] = 0;
+        uint32_t next[MAX_CODE_BITS + 1];
+        uint32_t code = 0;
+        for (int bits = 1; bits <= MAX_CODE_BITS; bits++) {
+                code = (code + count[bits - 1]) << 1;
+                next[bits] = code;
+                if (code + count[bits] > (1u << bits)) {
+                        return 0;
+                }
+        }
+        for (int s = 0; s < n; s++) {
+                if (lengths[s] > 0) {
+                        codes[s] = next[lengths[s]]++;
+                }
+        }
+        return 1;
+}
+
+/***************************encode_stream*********************************
+*
+* Appends the code lengths, the length and the coded bytes of one stream of
+* symbols to out
+*
+*********************************************************************/
+static void encode_stream(struct Output *out, const int32_t *symbols, long n,
+                          int nsymbols)
+{
+        long counts[MAX_SYMBOLS] = { 0 };
+        for (long i = 0; i < n; i++) {
+                counts[symbols[i]]++;
+        }
+        unsigned char lengths[MAX_SYMBOLS] = { 0 };
+        uint32_t codes[MAX_SYMBOLS];
+        code_lengths(counts, nsymbols, lengths);
+        int valid = canonical_codes(lengths, nsymbols, codes);
+        assert(valid);
+        for (int s = 0; s < nsymbols; s += 2) {
+                put_byte(out, lengths[s] << 4 | lengths[s + 1]);
+        }
+
+        long start = out->length;
+        for (int k = 0; k < 4; k++) {
+                put_byte(out, 0);
+        }
+        uint64_t bits = 0;
+        int held = 0;
+        for (long i = 0; i < n; i++) {
+                int s = symbols[i];
+                bits = bits << lengths[s] | codes[s];
+                held += lengths[s];
+                while (held >= 8) {
+                        held -= 8;
+                        put_byte(out, bits >> held);
+                }
+        }
+        if (held > 0) {
+                put_byte(out, bits << (8 - held));
+        }
+        long coded = out->length - start - 4;
+        for (int k = 0; k < 4; k++) {
+                out->bytes[start + k] = coded >> (24 - 8 * k);
+        }
+}
+
+/***************************decode_stream*********************************
+*
+* Decodes n symbols coded with the given code lengths
+*
+* Parameters: const unsigned char *bytes, long length: the coded symbols
+*             const unsigned char *lengths, int nsymbols: the code lengths
+*             int32_t *symbols: where to store the n symbols
+*
+* Return: 1, or 0 if the code lengths are invalid or the symbols are corrupt
+*
+* Notes: keeps up to 64 bits of the stream in a register, and looks up the
+*        next MAX_CODE_BITS of them in a table of each symbol and its length.
+*        Bits past the end of the stream read as 0, and a stream that ends
+*        before its last symbol is caught once every symbol is decoded.
+*********************************************************************/
+static int decode_stream(const unsigned char *bytes, long length,
+                         const unsigned char *lengths, int nsymbols,
+                         int32_t *symbols, long n)
+{
+        uint32_t codes[MAX_SYMBOLS];
+        if (!canonical_codes(lengths, nsymbols, codes)) {
+                return 0;
+        }
+        uint16_t table[1 << MAX_CODE_BITS];
+        memset(table, 0, sizeof(table));
+        for (int s = 0; s < nsymbols; s++) {
+                int shift = MAX_CODE_BITS - lengths[s];
+                if (lengths[s] == 0) {
+                        continue;
+                }
+                for (uint32_t low = 0; low < (1u << shift); low++) {
+                        table[codes[s] << shift | low] = s << 4 | lengths[s];
+                }
+        }
+
+        uint64_t bits = 0;
+        int held = 0;
+        long next = 0, used = 0;
+        for (long i = 0; i < n; i++) {
+                while (held <= 56) {
+                        uint64_t byte = next < length ? bytes[next] : 0;
+                        bits |= byte << (56 - held);
+                        next++;
+                        held += 8;
+                }
+                int entry = table[bits >> (64 - MAX_CODE_BITS)];
+                int bitlength = entry & 15;
+                if (bitlength == 0) {
+                        return 0;
+                }
+                symbols[i] = entry >> 4;
+                bits <<= bitlength;
+                held -= bitlength;
+                used += bitlength;
+        }
+        return used <= 8 * length;
+}
+
+/***************************Entropy_encode*********************************
+*
+* Entropy codes the code words of a tile
+*
+* Parameters: const unsigned char *codewords: width * height big endian code
+*                                             words, in row-major order
+*             int width, height: the size of the tile in blocks
+*             long *length: where to store the number of bytes returned
+*
+* Expects: codewords and length are not NULL and the tile is not empty,
+*          which are checked runtime errors
+*
+* Return: the coded tile, laid out as at the top of this file
+*
+*********************************************************************/
+unsigned char *Entropy_encode(const unsigned char *codewords, int width,
+                              int height, long *length)
+{
+        assert(codewords != NULL && length != NULL);
+        assert(width > 0 && height > 0);
+        long n = (long) width * height;
+        int32_t *fields = ALLOC(CODEWORD_NFIELDS * n * sizeof(*fields));
+        Codeword_unpack_row(codewords, n, Codeword_row_at(fields, n, 0));
+
+        struct Output out = { NULL, 0, n + 256 };
+        out.bytes = ALLOC(out.capacity);
+        for (int f = 0; f < CODEWORD_NFIELDS; f++) {
+                int32_t *symbols = fields + f * n;
+                int32_t mask = (1 << widths[f]) - 1;
+                /* Backwards, so each prediction still sees its values */
+                for (long i = n - 1; i >= 0; i--) {
+                        int32_t guess = predicted[f] ?
+                                        prediction(symbols, i, width) : 0;
+                        symbols[i] = (symbols[i] - guess) & mask;
+                }
+                encode_stream(&out, symbols, n, 1 << widths[f]);
+        }
+        FREE(fields);
+        *length = out.length;
+        return out.bytes;
+}
+
+/***************************Entropy_decode*********************************
+*
+* Decodes the code words of an entropy coded tile
+*
+* Parameters: const unsigned char *bytes, long length: the coded tile
+*             int width, height: the size of the tile in blocks
+*             unsigned char *codewords: where to store the width * height
+*                                       big endian code words
+*
+* Expects: bytes and codewords are not NULL and the tile is not empty, which
+*          are checked runtime errors
+*
+* Return: nothing
+*
+* Notes: Raises Entropy_Corrupt, after freeing its memory, if the bytes are
+*        cut short, have invalid code lengths, or hold a code that does not
+*        exist
+*********************************************************************/
+void Entropy_decode(const unsigned char *bytes, long length, int width,
+                    int height, unsigned char *codewords)
+{
+        assert(bytes != NULL && codewords != NULL);
+        assert(width > 0 && height > 0 && length >= 0);
+        long n = (long) width * height;
+        int32_t *fields = ALLOC(CODEWORD_NFIELDS * n * sizeof(*fields));
+        const unsigned char *end = bytes + length;
+        int valid = 1;
+        for (int f = 0; valid && f < CODEWORD_NFIELDS; f++) {
+                int nsymbols = 1 << widths[f];
+                if (end - bytes < nsymbols / 2 + 4) {
+                        valid = 0;
+                        break;
+                }
+                unsigned char lengths[MAX_SYMBOLS];
+                for (int s = 0; s < nsymbols; s += 2) {
+                        lengths[s] = *bytes >> 4;
+                        lengths[s + 1] = *bytes++ & 15;
+                }
+                long coded = (long) bytes[0] << 24 | (long) bytes[1] << 16 |
+                             (long) bytes[2] << 8 | (long) bytes[3];
+                bytes += 4;
+                if (coded > end - bytes) {
+                        valid = 0;
+                        break;
+                }
+
+                int32_t *symbols = fields + f * n;
+                valid = decode_stream(bytes, coded, lengths, nsymbols,
+                                      symbols, n);
+                bytes += coded;
+                int32_t mask = nsymbols - 1;
+                for (long i = 0; valid && predicted[f] && i < n; i++) {
+                        symbols[i] = (symbols[i] +
+                                      prediction(symbols, i, width)) & mask;
+                }
+        }
+        if (valid && bytes == end) {
+                Codeword_pack_row(Codeword_row_at(fields, n, 0), n,
+                                  codewords);
+        } else {
+                valid = 0;
+        }
+        FREE(fields);
+        if (!valid) {
+                TRAISE(Entropy_Corrupt);
+        }
+}
+
+#undef PREDICTED_UNSIGNED
+#undef PREDICTED_SIGNED
+#undef MAX_CODE_BITS
+#undef MAX_SYMBOLS
@@ -0,0 +1,35 @@
+/*
+ *     entropy.h
+ *     by Abhinav Mummameni (amumma01) and Rolando Ortega (rorteg02)
+ *
+ *     Interface for entropy coding the code words of a tile. Each field of
+ *     CODEWORD_FIELDS is coded as its own stream of symbols with a canonical
+ *     Huffman code built for that stream, so the b, c and d fields, which
+ *     are nearly always close to 0, take only a few bits each. The a, pb_bar
+ *     and pr_bar fields are first predicted from the block to the left (or
+ *     above, at the start of a row), since neighboring blocks tend to share
+ *     them. Decoding is lossless: it gives back exactly the code words that
+ *     were encoded.
+ */
+
+#ifndef ENTROPY_INCLUDED
+#define ENTROPY_INCLUDED
+
+#include "except.h"
+
+/* Raised when coded bytes cannot be decoded */
+extern Except_T Entropy_Corrupt;
+
+/* Codes the width * height big endian code words of a tile, in row-major
+ * order. Returns a new array, which the caller must FREE, and stores its
+ * length in *length. Checked runtime error if the tile is empty. */
+extern unsigned char *Entropy_encode(const unsigned char *codewords,
+                                     int width, int height, long *length);
+
+/* Decodes length bytes from Entropy_encode back into the width * height
+ * code words of the tile. Raises Entropy_Corrupt if the bytes are not a
+ * tile of that size. */
+extern void Entropy_decode(const unsigned char *bytes, long length,
+                           int width, int height, unsigned char *codewords);
+
+#endif
@@ -0,0 +1,306 @@
+/*
+ *     fixed.c
+ *     by Abhinav Mummameni (amumma01) and Rolando Ortega (rorteg02)
+ *
+ *     Implementation of the fixed-point compressor. Every quantity is kept as
+ *     an integer multiple of 1 / scale, where scale = 4 * denominator * 2^16:
+ *     the color space coefficients are rounded to multiples of 2^-16 (each 
+ *     row of them still sums exactly to 1 or 0), and summing the 4 pixels of
+ *     a block, instead of averaging them, absorbs the 4. Quantizing is then a
+ *     multiply by a constant and a shift. The shift grows with the bit 
+ *     length of the denominator, so the constant keeps about QUANT_BITS 
+ *     significant bits for every denominator. Chroma indices come from 
+ *     comparing the chroma sums with the chroma interface's thresholds, 
+ *     converted to the same scale.
+ *
+ *     Decoding is table driven. Each quantized a, b, c and d has a table 
+ *     entry with its share of the luma of a pixel, and each of the 256 
+ *     pairs of chroma indices has an entry with the offset it adds to each 
+ *     of red, green and blue, all in 255ths with DECODE_BITS of fraction. A
+ *     pixel is then its luma plus the offset of its channel, rounded and 
+ *     clamped.
+ */
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <math.h>
+#include "assert.h"
+#include "mem.h"
+#include "chroma.h"
+#include "fixed.h"
+
+#define T Fixed_T
+#define COEFF_BITS 16
+#define QUANT_BITS 20
+#define MAX_DENOMINATOR 65535
+#define DECODE_BITS 16
+#define DECODE_DENOMINATOR 255
+#define DCT_LEVELS 64           /* every 6-bit b, c and d, -32 to 31 */
+
+/* The color space matrix of conversion.c, times 2^COEFF_BITS */
+static const int64_t Y_RED = 19595, Y_GREEN = 38470, Y_BLUE = 7471;
+static const int64_t PB_RED = -11058, PB_GREEN = -21710, PB_BLUE = 32768;
+static const int64_t PR_RED = 32768, PR_GREEN = -27439, PR_BLUE = -5329;
+
+/* struct T - scaled constants for one denominator. a_mult and dct_mult turn
+ * sums into a and b, c, d with shift bits of fraction; dct_limit is 0.3 on 
+ * the scale of the sums, and chroma[k] is the smallest chroma sum with an 
+ * index of at least k. The decode tables hold the luma of a and of each of
+ * b, c and d (offset by 32), and the red, green and blue offsets of each 
+ * pb_bar << 4 | pr_bar, which include the rounding bias. */
+struct T {
+        int shift;
+        int64_t a_mult;
+        int64_t dct_mult;
+        int64_t dct_limit;
+        int64_t chroma[CHROMA_LEVELS];
+        int32_t a_luma[64];
+        int32_t dct_luma[DCT_LEVELS];
+        int32_t offsets[CHROMA_LEVELS * CHROMA_LEVELS][3];
+};
+
+/* Fills in the decode tables, from the same constants conversion.c uses */
+static void build_decode_tables(T fixed)
+{
+        double unit = DECODE_DENOMINATOR * ldexp(1.0, DECODE_BITS);
+        for (int a = 0; a < 64; a++) {
+                fixed->a_luma[a] = lround(a / 63.0 * unit);
+        }
+        for (int q = 0; q < DCT_LEVELS; q++) {
+                fixed->dct_luma[q] = lround((q - DCT_LEVELS / 2) / 103.33 * 
+                                            unit);
+        }
+        int32_t half = 1 << (DECODE_BITS - 1);
+        for (unsigned i = 0; i < CHROMA_LEVELS * CHROMA_LEVELS; i++) {
+                double pb = Chroma_value(i >> 4);
+                double pr = Chroma_value(i & 0xf);
+                fixed->offsets[i][0] = lround(1.402 * pr * unit) + half;
+                fixed->offsets[i][1] = lround((-0.344136 * pb - 
+                                               0.714136 * pr) * unit) + half;
+                fixed->offsets[i][2] = lround(1.772 * pb * unit) + half;
+        }
+}
+
+/***************************Fixed_new**********************************
+*
+* Creates the constants for compressing an image with the given denominator
+*
+* Parameters: unsigned denominator: the denominator of the image
+*
+* Expects: denominator is between 1 and 65535, a checked runtime error
+*
+* Return: the constants, which the caller must free with Fixed_free
+*
+* Notes: A sum is below 2^(COEFF_BITS + 2 + bits), where bits is the bit 
+*        length of the denominator, and the multipliers are below 
+*        2^(QUANT_BITS + 8), so their products fit in 63 bits
+*
+*********************************************************************/
+T Fixed_new(unsigned denominator)
+{
+        assert(denominator > 0 && denominator <= MAX_DENOMINATOR);
+        int bits = 0;
+        while ((denominator >> bits) != 0) {
+                bits++;
+        }
+        double scale = 4.0 * denominator * (1 << COEFF_BITS);
+        T fixed;
+        NEW(fixed);
+        fixed->shift = COEFF_BITS + 2 + bits + QUANT_BITS;
+        double one = ldexp(1.0, fixed->shift);
+        fixed->a_mult = llround(63.0 * one / scale);
+        fixed->dct_mult = llround(103.33 * one / scale);
+        fixed->dct_limit = floor(0.3 * scale);
+        fixed->chroma[0] = INT64_MIN;
+        for (unsigned level = 1; level < CHROMA_LEVELS; level++) {
+                fixed->chroma[level] = ceil(Chroma_threshold(level) * scale);
+        }
+        build_decode_tables(fixed);
+        return fixed;
+}
+
+void Fixed_free(T *fixed)
+{
+        assert(fixed != NULL && *fixed != NULL);
+        FREE(*fixed);
+}
+
+/* Rounds value / scale * multiplier to the nearest integer, halves away from
+ * zero like round, after clamping the value to [-limit, limit] */
+static inline int quantize_dct(int64_t value, int64_t limit, int64_t mult,
+                               int shift)
+{
+        int64_t magnitude = value < 0 ? -value : value;
+        magnitude = magnitude > limit ? limit : magnitude;
+        int64_t q = (magnitude * mult + ((int64_t) 1 << (shift - 1))) >> 
+                    shift;
+        return value < 0 ? -q : q;
+}
+
+/* The number of chroma thresholds the sum has reached */
+static inline int chroma_index(const int64_t *thresholds, int64_t sum)
+{
+        int index = 0;
+        for (int level = 1; level < CHROMA_LEVELS; level++) {
+                index += sum >= thresholds[level];
+        }
+        return index;
+}
+
+/***************************Fixed_quantize_row*******************************
+*
+* Quantizes a row of 2x2 blocks straight from their pixels
+*
+* Parameters: T fixed: the constants for the image's denominator
+*             const struct Pnm_rgb *top: the first pixel row of the block row
+*             const struct Pnm_rgb *bottom: the second pixel row
+*             int count: the number of blocks
+*             struct Codeword_row fields: where to store the fields
+*
+* Expects: fixed, top and bottom are not NULL (checked runtime errors), each 
+*          row holds 2 * count pixels no larger than the denominator, and 
+*          every array of fields has room for count values
+*
+* Return: nothing
+*
+* Notes: The lumas are kept on the scale of the sums of 4 pixels, so the DCT
+*        needs no division, and the sums of Y are never negative. Like the
+*        floating point path, a is never more than 63.
+*
+*********************************************************************/
+void Fixed_quantize_row(T fixed, const struct Pnm_rgb *top, 
+                        const struct Pnm_rgb *bottom, int count, 
+                        struct Codeword_row fields)
+{
+        assert(fixed != NULL && top != NULL && bottom != NULL);
+        int shift = fixed->shift;
+        for (int i = 0; i < count; i++) {
+                const struct Pnm_rgb *pixels[4] = { &top[2 * i], 
+                                                    &top[2 * i + 1],
+                                                    &bottom[2 * i], 
+                                                    &bottom[2 * i + 1] };
+                int64_t y[4];
+                int64_t pb = 0, pr = 0;
+                for (int k = 0; k < 4; k++) {
+                        int64_t r = pixels[k]->red;
+                        int64_t g = pixels[k]->green;
+                        int64_t b = pixels[k]->blue;
+                        y[k] = Y_RED * r + Y_GREEN * g + Y_BLUE * b;
+                        pb += PB_RED * r + PB_GREEN * g + PB_BLUE * b;
+                        pr += PR_RED * r + PR_GREEN * g + PR_BLUE * b;
+                }
+
+                int64_t a = (y[0] + y[1] + y[2] + y[3]) * fixed->a_mult + 
+                            ((int64_t) 1 << (shift - 1));
+                a >>= shift;
+                fields.a[i] = a > 63 ? 63 : a;
+                fields.b[i] = quantize_dct(y[2] + y[3] - y[0] - y[1], 
+                                           fixed->dct_limit, fixed->dct_mult,
+                                           shift);
+                fields.c[i] = quantize_dct(y[1] + y[3] - y[0] - y[2], 
+                                           fixed->dct_limit, fixed->dct_mult,
+                                           shift);
+                fields.d[i] = quantize_dct(y[0] + y[3] - y[1] - y[2], 
+                                           fixed->dct_limit, fixed->dct_mult,
+                                           shift);
+                fields.pb_bar[i] = chroma_index(fixed->chroma, pb);
+                fields.pr_bar[i] = chroma_index(fixed->chroma, pr);
+        }
+}
+
+/* Rounds (the bias is in the offset) and clamps a channel to [0, 255] */
+static inline unsigned char decode_channel(int32_t value)
+{
+        value >>= DECODE_BITS;
+        return value < 0 ? 0 : value > DECODE_DENOMINATOR ? 
+                               DECODE_DENOMINATOR : value;
+}
+
+/***************************Fixed_decode_row*********************************
+*
+* Decodes a row of code words straight into raw 8-bit pixels
+*
+* Parameters: T fixed: the decode tables
+*             struct Codeword_row fields: the fields of each code word
+*             int count: the number of code words
+*             unsigned char *top: the raster of the first pixel row
+*             unsigned char *bottom: the raster of the second pixel row
+*
+* Expects: fixed, top and bottom are not NULL (checked runtime errors), every
+*          array of fields holds count values that fit their fields, and each
+*          raster has room for 6 * count bytes
+*
+* Return: nothing
+*
+* Notes: The inverse DCT is four sums of table entries, one per pixel, in 
+*        the order of the rows of DCT_TO_LUMAS in conversion.c, and each 
+*        channel of a pixel is its luma plus the channel's chroma offset.
+*
+*********************************************************************/
+void Fixed_decode_row(T fixed, struct Codeword_row fields, int count,
+                      unsigned char *top, unsigned char *bottom)
+{
+        assert(fixed != NULL && top != NULL && bottom != NULL);
+        const int32_t *dct = fixed->dct_luma + DCT_LEVELS / 2;
+        for (int i = 0; i < count; i++) {
+                int32_t a = fixed->a_luma[fields.a[i]];
+                int32_t b = dct[fields.b[i]];
+                int32_t c = dct[fields.c[i]];
+                int32_t d = dct[fields.d[i]];
+                int32_t luma[4] = { a - b - c + d, a - b + c - d, 
+                                    a + b - c - d, a + b + c + d };
+                const int32_t *offset = 
+                        fixed->offsets[fields.pb_bar[i] << 4 | 
+                                       fields.pr_bar[i]];
+                unsigned char *pixels[4] = { top + 6 * i, top + 6 * i + 3,
+                                             bottom + 6 * i, 
+                                             bottom + 6 * i + 3 };
+                for (int k = 0; k < 4; k++) {
+                        pixels[k][0] = decode_channel(luma[k] + offset[0]);
+                        pixels[k][1] = decode_channel(luma[k] + offset[1]);
+                        pixels[k][2] = decode_channel(luma[k] + offset[2]);
+                }
+        }
+}
+
+/***************************Fixed_thumbnail_row******************************
+*
+* Decodes a row of code words into one raw 8-bit pixel per block
+*
+* Parameters: T fixed: the decode tables
+*             struct Codeword_row fields: the fields of each code word
+*             int count: the number of code words
+*             unsigned char *row: the raster of the pixels
+*
+* Expects: fixed and row are not NULL (checked runtime errors), the a, pb_bar
+*          and pr_bar arrays of fields hold count values that fit their 
+*          fields, and row has room for 3 * count bytes
+*
+* Return: nothing
+*
+* Notes: Each pixel is the luma of a plus the chroma offsets, just as 
+*        Fixed_decode_row decodes a block whose b, c and d are 0
+*
+*********************************************************************/
+void Fixed_thumbnail_row(T fixed, struct Codeword_row fields, int count,
+                         unsigned char *row)
+{
+        assert(fixed != NULL && row != NULL);
+        for (int i = 0; i < count; i++) {
+                int32_t luma = fixed->a_luma[fields.a[i]];
+                const int32_t *offset = 
+                        fixed->offsets[fields.pb_bar[i] << 4 | 
+                                       fields.pr_bar[i]];
+                row[3 * i] = decode_channel(luma + offset[0]);
+                row[3 * i + 1] = decode_channel(luma + offset[1]);
+                row[3 * i + 2] = decode_channel(luma + offset[2]);
+        }
+}
+
+#undef DECODE_BITS
+#undef DECODE_DENOMINATOR
+#undef DCT_LEVELS
+#undef COEFF_BITS
+#undef QUANT_BITS
+#undef MAX_DENOMINATOR
+#undef T
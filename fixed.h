@@ -0,0 +1,48 @@
+/*
+ *     fixed.h
+ *     by Abhinav Mummameni (amumma01) and Rolando Ortega (rorteg02)
+ *
+ *     Interface for the fixed-point codec: an alternative to the floating 
+ *     point path in conversion.c that goes straight from the integer pixels
+ *     of a block row to the fields of its code words, and from the fields 
+ *     straight back to raw 8-bit pixels, with scaled integer arithmetic and 
+ *     table lookups, and no divisions or calls to round. Its results can 
+ *     differ slightly from those of the floating point path; see the README
+ *     for the measured bound.
+ */
+
+#ifndef FIXED_INCLUDED
+#define FIXED_INCLUDED
+
+#include "pnm.h"
+#include "codeword.h"
+
+#define T Fixed_T
+typedef struct T *T;
+
+/* Creates the constants for compressing an image with the given 
+ * denominator, and the tables for decompressing to a denominator of 255.
+ * Checked runtime error if denominator is 0 or above 65535. */
+extern T    Fixed_new (unsigned denominator);
+extern void Fixed_free(T *fixed);
+
+/* Quantizes the count 2x2 blocks covered by two pixel rows, each at least
+ * 2 * count pixels long, into the fields of their code words */
+extern void Fixed_quantize_row(T fixed, const struct Pnm_rgb *top, 
+                               const struct Pnm_rgb *bottom, int count, 
+                               struct Codeword_row fields);
+
+/* Decodes the fields of count code words into the two rows of raw 8-bit 
+ * pixels (3 bytes each, as in a P6 raster) that their blocks cover. Each row
+ * must have room for 2 * count pixels. */
+extern void Fixed_decode_row(T fixed, struct Codeword_row fields, int count,
+                             unsigned char *top, unsigned char *bottom);
+
+/* Decodes the fields of count code words into one raw 8-bit pixel per 
+ * block, from its a, pb_bar and pr_bar fields alone. row must have room for
+ * count pixels. */
+extern void Fixed_thumbnail_row(T fixed, struct Codeword_row fields, 
+                                int count, unsigned char *row);
+
+#undef T
+#endif
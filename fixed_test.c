@@ -0,0 +1,199 @@
+/*
+ *     fixed_test.c
+ *     by Abhinav Mummameni (amumma01) and Rolando Ortega (rorteg02)
+ *
+ *     Test program, built and run by 'make test', for the fixed-point codec.
+ *     Quantizes rows of random, smooth and extreme pixels with both
+ *     Fixed_quantize_row and the floating point path (getCompressedRow and
+ *     quantize_row), for 8-bit, 16-bit and other denominators, and fails if
+ *     any field of any code word differs by more than one step, or if a
+ *     white block does not get an a of 63. Then decodes code words with 
+ *     every a and the extreme b, c and d values, down to -32, with both
+ *     Fixed_decode_row and the floating point path (dequantize_row and
+ *     setPixelsRow), and fails if any channel differs by more than 1.
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdint.h>
+#include "assert.h"
+#include "conversion.h"
+#include "codeword.h"
+#include "fixed.h"
+#include "testutil.h"
+
+#define BLOCKS 512
+#define ROWS 200
+#define DECODE_DENOMINATOR 255
+
+/* Fills a pixel with content of the given kind: 0 is uniform noise, 1 a
+ * smooth gradient, 2 only 0 or the denominator in each channel, and 3
+ * white */
+static void make_pixel(struct Pnm_rgb *pixel, int kind, unsigned denominator,
+                       int col, int row)
+{
+        unsigned *channels[3] = { &pixel->red, &pixel->green, &pixel->blue };
+        for (int k = 0; k < 3; k++) {
+                unsigned long value;
+                if (kind == 0) {
+                        value = Testutil_random() % (denominator + 1UL);
+                } else if (kind == 1) {
+                        value = (unsigned long) denominator *
+                                ((col + 3 * row + 97 * k) % 1024) / 1023;
+                } else if (kind == 2) {
+                        value = Testutil_random() % 2 ? denominator : 0;
+                } else {
+                        value = denominator;
+                }
+                *channels[k] = value;
+        }
+}
+
+/* Compares the fields of the two paths for ROWS block rows of one kind of
+ * content. Returns the number of failures, and adds the number of code
+ * words that differ at all to *differ. */
+static int check_kind(Fixed_T fixed, unsigned denominator, int kind,
+                      long *differ)
+{
+        static struct Pnm_rgb top[2 * BLOCKS], bottom[2 * BLOCKS];
+        static Compressed blocks[BLOCKS];
+        static int32_t float_storage[CODEWORD_NFIELDS * BLOCKS];
+        static int32_t fixed_storage[CODEWORD_NFIELDS * BLOCKS];
+        struct Codeword_row float_row =
+                Codeword_row_at(float_storage, BLOCKS, 0);
+        struct Codeword_row fixed_row =
+                Codeword_row_at(fixed_storage, BLOCKS, 0);
+        int failures = 0;
+
+        for (int row = 0; row < ROWS; row++) {
+                for (int col = 0; col < 2 * BLOCKS; col++) {
+                        make_pixel(&top[col], kind, denominator, col,
+                                   2 * row);
+                        make_pixel(&bottom[col], kind, denominator, col,
+                                   2 * row + 1);
+                }
+                getCompressedRow(top, bottom, BLOCKS, denominator, blocks);
+                quantize_row(blocks, BLOCKS, float_row);
+                Fixed_quantize_row(fixed, top, bottom, BLOCKS, fixed_row);
+
+                for (int i = 0; i < BLOCKS; i++) {
+                        int worst = 0, field = 0;
+                        for (int f = 0; f < CODEWORD_NFIELDS; f++) {
+                                long j = (long) f * BLOCKS + i;
+                                int step = abs(float_storage[j] -
+                                               fixed_storage[j]);
+                                if (step > worst) {
+                                        worst = step;
+                                        field = f;
+                                }
+                        }
+                        *differ += worst > 0;
+                        if (worst > 1 || (kind == 3 && fixed_row.a[i] != 63)) {
+                                fprintf(stderr, "FAIL: denominator %u, kind "
+                                        "%d, block %d of row %d: field %d "
+                                        "is %d, not %d\n", denominator, kind,
+                                        i, row, field,
+                                        fixed_storage[field * BLOCKS + i],
+                                        float_storage[field * BLOCKS + i]);
+                                failures++;
+                        }
+                }
+        }
+        return failures;
+}
+
+/* Decodes one row of count code words with both paths, and compares their
+ * pixels. Returns the number of failures. */
+static int check_decode_row(Fixed_T fixed, struct Codeword_row fields, 
+                            int count)
+{
+        static Compressed blocks[BLOCKS];
+        static struct Pnm_rgb top[2 * BLOCKS], bottom[2 * BLOCKS];
+        static unsigned char raw[2][6 * BLOCKS];
+        dequantize_row(fields, count, blocks);
+        setPixelsRow(blocks, count, DECODE_DENOMINATOR, top, bottom);
+        Fixed_decode_row(fixed, fields, count, raw[0], raw[1]);
+
+        int failures = 0;
+        struct Pnm_rgb *rows[2] = { top, bottom };
+        for (int r = 0; r < 2; r++) {
+                for (int col = 0; col < 2 * count; col++) {
+                        int expected[3] = { rows[r][col].red, 
+                                            rows[r][col].green,
+                                            rows[r][col].blue };
+                        for (int k = 0; k < 3; k++) {
+                                int got = raw[r][3 * col + k];
+                                if (abs(got - expected[k]) <= 1) {
+                                        continue;
+                                }
+                                int i = col / 2;
+                                fprintf(stderr, "FAIL: decoding a %d, b %d, "
+                                        "c %d, d %d gives channel %d of "
+                                        "pixel (%d, %d) as %d, not %d\n", 
+                                        fields.a[i], fields.b[i], 
+                                        fields.c[i], fields.d[i], k, col % 2,
+                                        r, got, expected[k]);
+                                failures++;
+                        }
+                }
+        }
+        return failures;
+}
+
+/* Decodes code words with every a, every combination of the extreme and
+ * middle b, c and d values, and every pair of chroma indices. Returns the 
+ * number of failures. */
+static int check_decode(void)
+{
+        static const int dct[] = { -32, -31, -1, 0, 1, 30, 31 };
+        int ndct = sizeof(dct) / sizeof(dct[0]);
+        static int32_t storage[CODEWORD_NFIELDS * BLOCKS];
+        struct Codeword_row fields = Codeword_row_at(storage, BLOCKS, 0);
+        Fixed_T fixed = Fixed_new(DECODE_DENOMINATOR);
+        int failures = 0, count = 0;
+        long words = 0;
+        for (int a = 0; a < 64; a++) {
+                for (int k = 0; k < ndct * ndct * ndct; k++) {
+                        fields.a[count] = a;
+                        fields.b[count] = dct[k % ndct];
+                        fields.c[count] = dct[k / ndct % ndct];
+                        fields.d[count] = dct[k / (ndct * ndct)];
+                        fields.pb_bar[count] = words % 16;
+                        fields.pr_bar[count] = words / 16 % 16;
+                        count++;
+                        words++;
+                        if (count == BLOCKS) {
+                                failures += check_decode_row(fixed, fields, 
+                                                             count);
+                                count = 0;
+                        }
+                }
+        }
+        failures += check_decode_row(fixed, fields, count);
+        printf("fixed decode: %d failures in %ld code words\n", failures, 
+               words);
+        Fixed_free(&fixed);
+        return failures;
+}
+
+int main(void)
+{
+        static const unsigned denominators[] = { 255, 65535, 1, 1000,
+                                                 4095, 65534 };
+        int ndenominators = sizeof(denominators) / sizeof(denominators[0]);
+        int failures = 0;
+        for (int d = 0; d < ndenominators; d++) {
+                Fixed_T fixed = Fixed_new(denominators[d]);
+                long differ = 0;
+                for (int kind = 0; kind < 4; kind++) {
+                        failures += check_kind(fixed, denominators[d], kind,
+                                               &differ);
+                }
+                printf("fixed quantize, denominator %u: %ld of %d code "
+                       "words differ by one step\n", denominators[d], differ,
+                       4 * ROWS * BLOCKS);
+                Fixed_free(&fixed);
+        }
+        failures += check_decode();
+        return failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
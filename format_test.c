@@ -0,0 +1,447 @@
+/*
+ *     format_test.c
+ *     by Abhinav Mummameni (amumma01) and Rolando Ortega (rorteg02)
+ *
+ *     Test program, built and run by 'make test', for the compressed image
+ *     formats and the decoders beyond decompress40_to. Every decode of a
+ *     test image is compared with the plain (format 2) decode of the same
+ *     image: whole tiled, entropy coded and run-length coded images with all
+ *     of it, the rectangles of decompress40_region with the same rectangles
+ *     of it, and thumbnails with the average of each of its 2 by 2 blocks.
+ *     Decodes of larger blocks are compared with the original image. Then
+ *     compressed images are cut short and corrupted, and regions outside 
+ *     them asked for, and decoding them must raise the right exception, 
+ *     handled here with TTRY, instead of reading past the end of the file
+ *     or stopping the program.
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include "assert.h"
+#include "except.h"
+#include "texcept.h"
+#include "compress40.h"
+#include "tiles.h"
+#include "entropy.h"
+#include "runs.h"
+#include "testutil.h"
+
+/* The size of the test image; the odd last column and row are trimmed */
+#define WIDTH 87
+#define HEIGHT 59
+#define TILE_SIZE 16
+
+/* How far a thumbnail may be from the average of each block of the plain
+ * decode, which is clamped pixel by pixel: 0.16 levels and one sample in
+ * 230 were measured */
+#define THUMBNAIL_MEAN_ERROR 0.5
+#define THUMBNAIL_OUTLIERS 100
+
+/* How far a decode of larger blocks may be from the original image, RMS:
+ * 7.6 levels for 4 by 4 blocks and 8.9 for 8 by 8 were measured, and 11.7
+ * for the usual 2 by 2 */
+#define BLOCKS_RMS_ERROR 10.0
+
+/* struct Image - A decoded image, with 3 bytes per pixel */
+struct Image {
+        unsigned width, height;
+        unsigned char *pixels;
+};
+
+/* The rectangle decode_region decodes: x, y, w and h */
+static unsigned region[4];
+
+/* Compresses the image in source, with the current compress40 settings,
+ * into a new temporary file, which is returned rewound */
+static FILE *compress_image(FILE *source)
+{
+        FILE *compressed = tmpfile();
+        assert(compressed != NULL);
+        rewind(source);
+        compress40_to(source, compressed);
+        rewind(compressed);
+        return compressed;
+}
+
+/* Returns a copy of the first keep bytes of fp (all of them if keep is
+ * negative) in a new temporary file, rewound, with the byte at flip
+ * inverted unless flip is negative */
+static FILE *edit_copy(FILE *fp, long keep, long flip)
+{
+        FILE *copy = tmpfile();
+        assert(copy != NULL);
+        rewind(fp);
+        int c;
+        for (long i = 0; (keep < 0 || i < keep) && (c = getc(fp)) != EOF;
+             i++) {
+                putc(i == flip ? c ^ 0xff : c, copy);
+        }
+        rewind(copy);
+        return copy;
+}
+
+/* Returns the number of bytes in fp */
+static long file_length(FILE *fp)
+{
+        fseek(fp, 0, SEEK_END);
+        long length = ftell(fp);
+        rewind(fp);
+        return length;
+}
+
+/* Returns the number of bytes in the first lines lines of fp */
+static long header_length(FILE *fp, int lines)
+{
+        rewind(fp);
+        long length = 0;
+        int c;
+        while (lines > 0 && (c = getc(fp)) != EOF) {
+                length++;
+                lines -= c == '\n';
+        }
+        rewind(fp);
+        return length;
+}
+
+/* Runs codec from input to a temporary file, and reads back the raw PPM
+ * image it writes */
+static struct Image decode(void codec(FILE *, FILE *), FILE *input)
+{
+        FILE *output = tmpfile();
+        assert(output != NULL);
+        rewind(input);
+        codec(input, output);
+        rewind(output);
+
+        struct Image image;
+        unsigned denominator;
+        int read = fscanf(output, "P6 %u %u %u", &image.width,
+                          &image.height, &denominator);
+        int c = getc(output);
+        assert(read == 3 && denominator == 255 && c == '\n');
+        size_t length = 3 * (size_t) image.width * image.height;
+        image.pixels = malloc(length + 1);
+        assert(image.pixels != NULL);
+        size_t got = fread(image.pixels, 1, length, output);
+        assert(got == length);
+        fclose(output);
+        return image;
+}
+
+/* Decodes the rectangle in region with decompress40_region */
+static void decode_region(FILE *input, FILE *output)
+{
+        decompress40_region(input, output, region[0], region[1], region[2],
+                            region[3]);
+}
+
+/* Checks that image is the w by h rectangle of full whose top left pixel
+ * is at (x, y). Returns the number of failures. */
+static int check_crop(struct Image image, struct Image full, unsigned x,
+                      unsigned y, unsigned w, unsigned h, const char *what)
+{
+        if (image.width != w || image.height != h) {
+                fprintf(stderr, "FAIL: %s is %ux%u, not %ux%u\n", what,
+                        image.width, image.height, w, h);
+                return 1;
+        }
+        for (unsigned row = 0; row < h; row++) {
+                if (memcmp(image.pixels + 3L * row * w, full.pixels +
+                           3L * ((long) (y + row) * full.width + x),
+                           3L * w) != 0) {
+                        fprintf(stderr, "FAIL: %s differs in row %u\n",
+                                what, row);
+                        return 1;
+                }
+        }
+        return 0;
+}
+
+/* Decodes all of a compressed image, and some rectangles of it, and checks
+ * each against the same part of full, the plain decode of the same image.
+ * Returns the number of failures. */
+static int check_decodes(FILE *compressed, struct Image full,
+                         const char *format)
+{
+        unsigned w = full.width, h = full.height;
+        const unsigned rects[][4] = {
+                { 0, 0, w, h }, { 0, 0, 1, 1 }, { 1, 1, 1, 1 },
+                { 3, 5, 30, 17 }, { w - 7, h - 3, 7, 3 }, { 15, 0, 2, h },
+                { 0, h / 2 + 1, w, 1 }, { TILE_SIZE - 1, TILE_SIZE - 1,
+                                          TILE_SIZE + 2, TILE_SIZE + 2 }
+        };
+        char what[128];
+        struct Image image = decode(decompress40_to, compressed);
+        snprintf(what, sizeof(what), "%s image", format);
+        int failures = check_crop(image, full, 0, 0, w, h, what);
+        free(image.pixels);
+        for (unsigned k = 0; k < sizeof(rects) / sizeof(rects[0]); k++) {
+                memcpy(region, rects[k], sizeof(region));
+                image = decode(decode_region, compressed);
+                snprintf(what, sizeof(what), "%s region %u,%u,%u,%u",
+                         format, region[0], region[1], region[2],
+                         region[3]);
+                failures += check_crop(image, full, region[0], region[1],
+                                       region[2], region[3], what);
+                free(image.pixels);
+        }
+        return failures;
+}
+
+/* Copies a PPM image, so that decode can read the original */
+static void copy_image(FILE *input, FILE *output)
+{
+        int c;
+        while ((c = getc(input)) != EOF) {
+                putc(c, output);
+        }
+}
+
+/* Checks that the thumbnail of a compressed image is close to the average
+ * of each 2 by 2 block of full, the plain decode of the same image: within
+ * THUMBNAIL_MEAN_ERROR levels on average, with at most one sample in
+ * THUMBNAIL_OUTLIERS off by more than 2 levels, where full was clamped.
+ * Returns the number of failures. */
+static int check_thumbnail(FILE *compressed, struct Image full,
+                           const char *format)
+{
+        struct Image image = decode(decompress40_thumbnail, compressed);
+        unsigned w = full.width / 2, h = full.height / 2;
+        if (image.width != w || image.height != h) {
+                fprintf(stderr, "FAIL: %s thumbnail is %ux%u, not %ux%u\n",
+                        format, image.width, image.height, w, h);
+                free(image.pixels);
+                return 1;
+        }
+        long samples = 3L * w * h, total = 0, outliers = 0;
+        for (long i = 0; i < samples; i++) {
+                long x = i / 3 % w, y = i / 3 / w, row = 3L * full.width;
+                const unsigned char *p = full.pixels + i % 3 + 2 * y * row +
+                                         6 * x;
+                int error = abs(4 * image.pixels[i] -
+                                (p[0] + p[3] + p[row] + p[row + 3]));
+                total += error;
+                outliers += error > 4 * 2;
+        }
+        free(image.pixels);
+        double mean = total / (4.0 * samples);
+        if (mean > THUMBNAIL_MEAN_ERROR ||
+            outliers * THUMBNAIL_OUTLIERS > samples) {
+                fprintf(stderr, "FAIL: %s thumbnail is off by %.2f levels "
+                        "on average, and by more than 2 in %ld samples\n",
+                        format, mean, outliers);
+                return 1;
+        }
+        return 0;
+}
+
+/* Checks that running codec on input raises expected. Returns the number
+ * of failures. */
+static int check_raises(const Except_T *expected, void codec(FILE *, FILE *),
+                        FILE *input, const char *what)
+{
+        const Except_T *volatile raised = NULL;
+        FILE *output = tmpfile();
+        assert(output != NULL);
+        rewind(input);
+        TTRY
+                codec(input, output);
+        TELSE
+                raised = Texcept_frame.exception;
+        TEND_TRY;
+        fclose(output);
+        fclose(input);
+        if (raised != expected) {
+                fprintf(stderr, "FAIL: %s raised '%s', not '%s'\n", what,
+                        raised != NULL ? raised->reason : "nothing",
+                        expected->reason);
+                return 1;
+        }
+        return 0;
+}
+
+/* Cuts short and corrupts the index and tiles of a tiled image. Returns
+ * the number of failures. */
+static int check_bad_tiles(FILE *tiled)
+{
+        long index = header_length(tiled, 2);
+        long length = file_length(tiled);
+        memcpy(region, (unsigned[]) { 2, 2, 4, 4 }, sizeof(region));
+        return check_raises(&Tiles_Badindex, decompress40_to,
+                            edit_copy(tiled, index + 20, -1),
+                            "tiled image cut short in its index") +
+               check_raises(&Tiles_Badindex, decompress40_to,
+                            edit_copy(tiled, -1, index + 8 * 2 + 7),
+                            "tiled image with a bad offset") +
+               check_raises(&SHORT_FILE, decompress40_to,
+                            edit_copy(tiled, length - 1, -1),
+                            "tiled image missing its last byte") +
+               check_raises(&SHORT_FILE, decode_region,
+                            edit_copy(tiled, length - 1, -1),
+                            "region of a tiled image cut short") +
+               check_raises(&BAD_HEADER, decompress40_to,
+                            edit_copy(tiled, -1, index - 3),
+                            "tiled image with a bad tile size");
+}
+
+/* Cuts short and corrupts the first tile of an entropy coded image. Returns
+ * the number of failures. */
+static int check_bad_coded(FILE *coded)
+{
+        Tiles_T layout = Tiles_new(WIDTH - 1, HEIGHT - 1, TILE_SIZE, 1);
+        long first = header_length(coded, 2) + 8 * (Tiles_count(layout) + 1);
+        Tiles_free(&layout);
+        long length = file_length(coded);
+        memcpy(region, (unsigned[]) { 2, 2, 4, 4 }, sizeof(region));
+        return check_raises(&SHORT_FILE, decompress40_to,
+                            edit_copy(coded, length - 1, -1),
+                            "entropy coded image missing its last byte") +
+               check_raises(&Entropy_Corrupt, decompress40_to,
+                            edit_copy(coded, -1, first),
+                            "entropy coded image with bad code lengths") +
+               check_raises(&Entropy_Corrupt, decode_region,
+                            edit_copy(coded, -1, first + 32),
+                            "entropy coded region with a bad length");
+}
+
+/* Cuts short the last row, which the region takes in, and corrupts the
+ * first row of a run-length coded image. Returns the number of failures. */
+static int check_bad_runs(FILE *runs)
+{
+        long first = header_length(runs, 2);
+        long length = file_length(runs);
+        memcpy(region, (unsigned[]) { 2, HEIGHT - 5, 4, 4 }, sizeof(region));
+        return check_raises(&SHORT_FILE, decompress40_to,
+                            edit_copy(runs, length - 1, -1),
+                            "run-length coded image missing its last byte") +
+               check_raises(&SHORT_FILE, decode_region,
+                            edit_copy(runs, length - 1, -1),
+                            "run-length coded region cut short") +
+               check_raises(&Runs_Corrupt, decompress40_to,
+                            edit_copy(runs, -1, first),
+                            "run-length coded image with a bad control") +
+               check_raises(&Runs_Corrupt, decode_region,
+                            edit_copy(runs, -1, first),
+                            "run-length coded region with a bad control");
+}
+
+/* Compresses source with side by side blocks (format 6), and checks that 
+ * the decode is the trimmed size of original and within BLOCKS_RMS_ERROR 
+ * of it, and that regions and thumbnails of it, which format 6 does not 
+ * have, raise NO_REGIONS. Returns the number of failures. */
+static int check_blocks(FILE *source, struct Image original, unsigned side)
+{
+        compress40_set_block_size(side);
+        FILE *blocks = compress_image(source);
+        compress40_set_block_size(2);
+        struct Image image = decode(decompress40_to, blocks);
+        unsigned w = original.width - original.width % side;
+        unsigned h = original.height - original.height % side;
+        int failures = 0;
+        if (image.width != w || image.height != h) {
+                fprintf(stderr, "FAIL: %ux%u blocks image is %ux%u, not "
+                        "%ux%u\n", side, side, image.width, image.height, w,
+                        h);
+                failures++;
+        } else {
+                double sum = 0;
+                for (long i = 0; i < 3L * w * h; i++) {
+                        long x = i / 3 % w, y = i / 3 / w;
+                        int error = image.pixels[i] - original.pixels[
+                                    3 * (y * original.width + x) + i % 3];
+                        sum += error * error;
+                }
+                double rms = sqrt(sum / (3.0 * w * h));
+                if (rms > BLOCKS_RMS_ERROR) {
+                        fprintf(stderr, "FAIL: %ux%u blocks image is off by"
+                                " %.2f levels RMS\n", side, side, rms);
+                        failures++;
+                }
+        }
+        free(image.pixels);
+        memcpy(region, (unsigned[]) { 0, 0, side, side }, sizeof(region));
+        failures += check_raises(&NO_REGIONS, decode_region,
+                                 edit_copy(blocks, -1, -1),
+                                 "region of a format 6 image") +
+                    check_raises(&NO_REGIONS, decompress40_thumbnail,
+                                 edit_copy(blocks, -1, -1),
+                                 "thumbnail of a format 6 image");
+        fclose(blocks);
+        return failures;
+}
+
+/* Checks that regions that are empty or not inside the image raise 
+ * BAD_REGION. Returns the number of failures. */
+static int check_bad_regions(FILE *compressed, struct Image full)
+{
+        unsigned w = full.width, h = full.height;
+        const unsigned rects[][4] = {
+                { 0, 0, 0, 1 }, { 0, 0, 1, 0 }, { w, 0, 1, 1 }, 
+                { 0, h, 1, 1 }, { 1, 0, w, 1 }, { 0, h - 1, 1, 2 },
+                { 1, 1, -1U, -1U }
+        };
+        char what[128];
+        int failures = 0;
+        for (unsigned k = 0; k < sizeof(rects) / sizeof(rects[0]); k++) {
+                memcpy(region, rects[k], sizeof(region));
+                snprintf(what, sizeof(what), "region %u,%u,%u,%u", 
+                         region[0], region[1], region[2], region[3]);
+                failures += check_raises(&BAD_REGION, decode_region,
+                                         edit_copy(compressed, -1, -1),
+                                         what);
+        }
+        return failures;
+}
+
+int main(void)
+{
+        int failures = 0;
+        FILE *source = tmpfile();
+        assert(source != NULL);
+        Testutil_write_image(source, WIDTH, HEIGHT, -1);
+
+        FILE *plain = compress_image(source);
+        struct Image full = decode(decompress40_to, plain);
+        failures += check_decodes(plain, full, "plain");
+        failures += check_thumbnail(plain, full, "plain");
+        failures += check_bad_regions(plain, full);
+
+        compress40_set_tile_size(TILE_SIZE);
+        FILE *tiled = compress_image(source);
+        compress40_set_tile_size(0);
+        failures += check_decodes(tiled, full, "tiled");
+        failures += check_thumbnail(tiled, full, "tiled");
+        failures += check_bad_tiles(tiled);
+
+        compress40_set_entropy_coding(1);
+        compress40_set_tile_size(TILE_SIZE);
+        FILE *coded = compress_image(source);
+        compress40_set_tile_size(0);
+        compress40_set_entropy_coding(0);
+        failures += check_decodes(coded, full, "entropy coded");
+        failures += check_thumbnail(coded, full, "entropy coded");
+        failures += check_bad_coded(coded);
+
+        compress40_set_run_length(1);
+        FILE *runs = compress_image(source);
+        compress40_set_run_length(0);
+        failures += check_decodes(runs, full, "run-length coded");
+        failures += check_thumbnail(runs, full, "run-length coded");
+        failures += check_bad_runs(runs);
+
+        struct Image original = decode(copy_image, source);
+        failures += check_blocks(source, original, 4);
+        failures += check_blocks(source, original, 8);
+        free(original.pixels);
+
+        fclose(runs);
+        fclose(coded);
+        fclose(tiled);
+        fclose(plain);
+        fclose(source);
+        free(full.pixels);
+        printf("format: %d failures\n", failures);
+        return failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
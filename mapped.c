@@ -0,0 +1,204 @@
+/*
+ *     mapped.c
+ *     by Abhinav Mummameni (amumma01) and Rolando Ortega (rorteg02)
+ *
+ *     Implementation of the Mapped interface using mmap, with a fallback to 
+ *     fread for inputs that cannot be mapped. The length asked for may come
+ *     from an untrusted header, so the fallback grows its array as the 
+ *     bytes arrive instead of allocating all of it up front.
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include "assert.h"
+#include "mem.h"
+#include "mapped.h"
+
+#define T Mapped_T
+#define READ_BLOCK (1L << 20)
+
+/* struct T - bytes[0, length) are the requested bytes. If the file was 
+ * mapped, region is the start of the mapping and region_length its size; 
+ * otherwise region is NULL and bytes were allocated. */
+struct T {
+        const unsigned char *bytes;
+        long length;
+        void *region;
+        size_t region_length;
+};
+
+/***************************map_input**********************************
+*
+* Tries to memory map up to length bytes of fp from its current position
+*
+* Return: 1 if the bytes were mapped into mapped, 0 if fp is not a regular 
+*         file or could not be mapped
+*
+*********************************************************************/
+static int map_input(FILE *fp, long length, Mapped_access access, T mapped)
+{
+        struct stat info;
+        int fd = fileno(fp);
+        if (fd < 0 || fstat(fd, &info) != 0 || !S_ISREG(info.st_mode)) {
+                return 0;
+        }
+
+        /* ftello accounts for anything stdio has already buffered */
+        off_t offset = ftello(fp);
+        if (offset < 0 || offset > info.st_size) {
+                return 0;
+        }
+        off_t available = info.st_size - offset;
+        mapped->length = available < length ? (long) available : length;
+        if (mapped->length == 0) {
+                return 1;
+        }
+
+        /* mmap needs a page aligned offset, so map from the start */
+        mapped->region_length = offset + mapped->length;
+        mapped->region = mmap(NULL, mapped->region_length, PROT_READ, 
+                              MAP_PRIVATE, fd, 0);
+        if (mapped->region == MAP_FAILED) {
+                mapped->region = NULL;
+                return 0;
+        }
+        madvise(mapped->region, mapped->region_length, 
+                access == MAPPED_RANDOM ? MADV_RANDOM : MADV_SEQUENTIAL);
+        mapped->bytes = (const unsigned char *) mapped->region + offset;
+        return 1;
+}
+
+/***************************read_input**********************************
+*
+* Reads up to length bytes of fp into a new array, a large block at a time
+*
+* Notes: The array starts at one block and doubles (up to length) only when 
+*        it fills, so a file that ends early never costs more than twice 
+*        the bytes it actually held, however large length is.
+*
+*********************************************************************/
+static void read_input(FILE *fp, long length, T mapped)
+{
+        long size = length < READ_BLOCK ? length : READ_BLOCK;
+        if (size == 0) {
+                return;
+        }
+        unsigned char *bytes = ALLOC(size);
+        long done = 0;
+        while (done < length) {
+                if (done == size) {
+                        size = length - size < size ? length : 2 * size;
+                        RESIZE(bytes, size);
+                }
+                long want = size - done < READ_BLOCK ? size - done : 
+                                                       READ_BLOCK;
+                size_t got = fread(bytes + done, 1, want, fp);
+                done += got;
+                if (got < (size_t) want) {
+                        break;
+                }
+        }
+        mapped->bytes = bytes;
+        mapped->length = done;
+}
+
+/* Returns a new, empty Mapped_T */
+static T mapped_new(void)
+{
+        T mapped;
+        NEW(mapped);
+        mapped->bytes = NULL;
+        mapped->length = 0;
+        mapped->region = NULL;
+        mapped->region_length = 0;
+        return mapped;
+}
+
+/***************************Mapped_input**********************************
+*
+* Gets the next length bytes of a file into memory
+*
+* Parameters: FILE *fp: the file to read from
+*             long length: the number of bytes wanted
+*             Mapped_access access: how the bytes will be read
+*
+* Expects: fp is not NULL and length is not negative, checked runtime errors
+*
+* Return: the bytes, which the caller must free with Mapped_free. Mapped_length
+*         is less than length only if the file ended first.
+*
+* Notes: Regular files are mapped with mmap, which leaves fp where it was. 
+*        Other files are read with fread, which moves fp past the bytes,
+*        into an array that only grows as big as the bytes that were there.
+*
+*********************************************************************/
+T Mapped_input(FILE *fp, long length, Mapped_access access)
+{
+        assert(fp != NULL && length >= 0);
+        T mapped = mapped_new();
+        if (!map_input(fp, length, access, mapped)) {
+                read_input(fp, length, mapped);
+        }
+        return mapped;
+}
+
+/***************************Mapped_map**********************************
+*
+* Memory maps the next length bytes of a file, if it can be mapped
+*
+* Parameters: FILE *fp: the file to map
+*             long length: the number of bytes wanted
+*             Mapped_access access: how the bytes will be read
+*
+* Expects: fp is not NULL and length is not negative, checked runtime errors
+*
+* Return: the bytes, which the caller must free with Mapped_free, or NULL if
+*         fp is not a regular file or could not be mapped
+*
+*********************************************************************/
+T Mapped_map(FILE *fp, long length, Mapped_access access)
+{
+        assert(fp != NULL && length >= 0);
+        T mapped = mapped_new();
+        if (!map_input(fp, length, access, mapped)) {
+                FREE(mapped);
+        }
+        return mapped;
+}
+
+/***************************Mapped_free**********************************
+*
+* Unmaps or frees the bytes of a Mapped_T, and frees the Mapped_T itself
+*
+* Expects: mapped and *mapped are not NULL, checked runtime error
+*
+*********************************************************************/
+void Mapped_free(T *mapped)
+{
+        assert(mapped != NULL && *mapped != NULL);
+        if ((*mapped)->region != NULL) {
+                munmap((*mapped)->region, (*mapped)->region_length);
+        } else if ((*mapped)->bytes != NULL) {
+                void *bytes = (void *) (*mapped)->bytes;
+                FREE(bytes);
+        }
+        FREE(*mapped);
+}
+
+const unsigned char *Mapped_bytes(T mapped)
+{
+        assert(mapped != NULL);
+        return mapped->bytes;
+}
+
+long Mapped_length(T mapped)
+{
+        assert(mapped != NULL);
+        return mapped->length;
+}
+
+#undef READ_BLOCK
+#undef T
@@ -0,0 +1,40 @@
+/*
+ *     mapped.h
+ *     by Abhinav Mummameni (amumma01) and Rolando Ortega (rorteg02)
+ *
+ *     Interface for getting the rest of an input file into memory all at 
+ *     once. Regular files are memory mapped; anything else (such as a pipe on
+ *     standard input) is read in large blocks. Either way, the caller gets 
+ *     the bytes as one array, so it can check their length once and then 
+ *     index them directly. A mapping is advised for reading straight 
+ *     through or for jumping around, as the caller says.
+ */
+
+#ifndef MAPPED_INCLUDED
+#define MAPPED_INCLUDED
+
+#include <stdio.h>
+
+#define T Mapped_T
+typedef struct T *T;
+
+/* How the caller will read the bytes, which decides the advice given to the
+ * kernel for a mapping: MAPPED_SEQUENTIAL to read ahead aggressively and
+ * drop pages once passed, MAPPED_RANDOM to fault in only the pages used */
+typedef enum { MAPPED_SEQUENTIAL, MAPPED_RANDOM } Mapped_access;
+
+/* Gets up to length bytes of fp, starting at its current position. Fewer 
+ * bytes are returned only if the file ends first. Checked runtime error if 
+ * fp is NULL or length is negative. */
+extern T    Mapped_input (FILE *fp, long length, Mapped_access access);
+
+/* Like Mapped_input, but only for files that can be memory mapped. Returns 
+ * NULL, without reading anything, for files that cannot. */
+extern T    Mapped_map   (FILE *fp, long length, Mapped_access access);
+extern void Mapped_free  (T *mapped);
+
+extern const unsigned char *Mapped_bytes (T mapped);
+extern long                 Mapped_length(T mapped);
+
+#undef T
+#endif
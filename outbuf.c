@@ -0,0 +1,123 @@
+/*
+ *     outbuf.c
+ *     by Abhinav Mummameni (amumma01) and Rolando Ortega (rorteg02)
+ *
+ *     Implementation of the Outbuf interface
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include "assert.h"
+#include "except.h"
+#include "mem.h"
+#include "outbuf.h"
+
+#define T Outbuf_T
+#define DEFAULT_CAPACITY (1L << 20)
+
+Except_T Outbuf_Failed = { "Could not write output" };
+
+/* struct T - bytes[0, length) are waiting to be written to fp */
+struct T {
+        FILE *fp;
+        unsigned char *bytes;
+        long length;
+        long capacity;
+};
+
+/***************************Outbuf_new**********************************
+*
+* Creates an empty buffer in front of the given file
+*
+* Parameters: FILE *fp: the file to write to
+*             long capacity: the size of the buffer in bytes, or 0 for the 
+*                            default size
+*
+* Expects: fp is not NULL and capacity is not negative, checked runtime errors
+*
+* Return: the new buffer, which the caller must free with Outbuf_free
+*
+*********************************************************************/
+T Outbuf_new(FILE *fp, long capacity)
+{
+        assert(fp != NULL && (capacity == 0 || capacity >= 4));
+        T buf;
+        NEW(buf);
+        buf->fp = fp;
+        buf->capacity = capacity > 0 ? capacity : DEFAULT_CAPACITY;
+        buf->bytes = ALLOC(buf->capacity);
+        buf->length = 0;
+        return buf;
+}
+
+/***************************Outbuf_free**********************************
+*
+* Flushes the buffer and frees its memory
+*
+* Parameters: T *buf: a pointer to the buffer to free
+*
+* Expects: buf and *buf are not NULL, checked runtime error
+*
+*********************************************************************/
+void Outbuf_free(T *buf)
+{
+        assert(buf != NULL && *buf != NULL);
+        Outbuf_flush(*buf);
+        FREE((*buf)->bytes);
+        FREE(*buf);
+}
+
+/* Writes length bytes to fp, raising Outbuf_Failed if they do not fit */
+static void write_all(FILE *fp, const void *bytes, long length)
+{
+        if (length > 0 && fwrite(bytes, 1, length, fp) != (size_t) length) {
+                RAISE(Outbuf_Failed);
+        }
+}
+
+/***************************Outbuf_flush**********************************
+*
+* Writes everything in the buffer to its file with a single fwrite
+*
+* Parameters: T buf: the buffer to flush
+*
+* Expects: buf is not NULL, checked runtime error
+*
+* Notes: Raises Outbuf_Failed if the write fails
+*
+*********************************************************************/
+void Outbuf_flush(T buf)
+{
+        assert(buf != NULL);
+        write_all(buf->fp, buf->bytes, buf->length);
+        buf->length = 0;
+}
+
+/***************************Outbuf_put_bytes*********************************
+*
+* Appends bytes to the buffer, flushing first if they do not fit
+*
+* Parameters: T buf: the buffer to add to
+*             const void *bytes: the bytes to add
+*             long length: the number of bytes to add
+*
+* Expects: buf is not NULL and length is not negative, checked runtime errors
+*
+*********************************************************************/
+void Outbuf_put_bytes(T buf, const void *bytes, long length)
+{
+        assert(buf != NULL && length >= 0);
+        if (buf->length + length > buf->capacity) {
+                Outbuf_flush(buf);
+        }
+        if (length >= buf->capacity) {
+                write_all(buf->fp, bytes, length);
+                return;
+        }
+        memcpy(buf->bytes + buf->length, bytes, length);
+        buf->length += length;
+}
+
+#undef DEFAULT_CAPACITY
+#undef T
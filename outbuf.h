@@ -0,0 +1,39 @@
+/*
+ *     outbuf.h
+ *     by Abhinav Mummameni (amumma01) and Rolando Ortega (rorteg02)
+ *
+ *     Interface for a large output buffer in front of a FILE. Bytes, usually
+ *     a block row of code words packed by Codeword_pack_row, are copied into
+ *     the buffer and written out with a single fwrite whenever it fills, 
+ *     instead of with one stdio call per byte.
+ */
+
+#ifndef OUTBUF_INCLUDED
+#define OUTBUF_INCLUDED
+
+#include <stdio.h>
+#include "except.h"
+
+#define T Outbuf_T
+typedef struct T *T;
+
+/* Raised when the FILE will not take the bytes written to it */
+extern Except_T Outbuf_Failed;
+
+/* Creates a buffer that writes to fp. A capacity of 0 picks a default of 
+ * 1MB. Checked runtime error if fp is NULL or capacity is between 1 and 3 or
+ * negative. */
+extern T    Outbuf_new  (FILE *fp, long capacity);
+
+/* Flushes and frees the buffer. Does not close its FILE. */
+extern void Outbuf_free (T *buf);
+
+/* Writes everything in the buffer to its FILE */
+extern void Outbuf_flush(T buf);
+
+/* Appends length bytes to the buffer. Lengths at least as large as the 
+ * buffer are written straight through. */
+extern void Outbuf_put_bytes    (T buf, const void *bytes, long length);
+
+#undef T
+#endif
@@ -0,0 +1,165 @@
+/*
+ *     parallel.c
+ *     by Abhinav Mummameni (amumma01) and Rolando Ortega (rorteg02)
+ *
+ *     Implementation of the parallel interface using POSIX threads.
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <pthread.h>
+#include <unistd.h>
+#include "assert.h"
+#include "mem.h"
+#include "parallel.h"
+
+/* struct Chunk - One thread's share of the range */
+struct Chunk {
+        pthread_t thread;
+        int lo, hi;
+        Parallel_applyfun *apply;
+        void *cl;
+};
+
+static void *run_chunk(void *vchunk)
+{
+        struct Chunk *chunk = vchunk;
+        chunk->apply(chunk->lo, chunk->hi, chunk->cl);
+        return NULL;
+}
+
+/***************************Parallel_for**********************************
+*
+* Splits [0, count) into contiguous chunks and calls apply on each chunk from
+* its own thread
+*
+* Parameters: unsigned nthreads: the most threads to use, counting the caller
+*             int count: the number of indices
+*             Parallel_applyfun apply: called once per chunk
+*             Parallel_applyfun done: if not NULL, called on each chunk in 
+*                       order, from the calling thread, once it is finished
+*             void *cl: a closure passed to apply and done
+*
+* Expects: nthreads is not 0 and count is not negative
+*
+* Return: nothing, but every index has been applied when it returns
+*
+* Notes: Never uses more threads than there are indices, and with only one
+*        chunk runs it directly without allocating. Chunk sizes differ by at 
+*        most one. Raises a checked runtime error if a thread cannot be 
+*        created.
+*********************************************************************/
+void Parallel_for(unsigned nthreads, int count, Parallel_applyfun apply, 
+                  Parallel_applyfun done, void *cl)
+{
+        assert(nthreads > 0 && count >= 0 && apply != NULL);
+        if (count == 0) {
+                return;
+        }
+        int n = (unsigned) count < nthreads ? count : (int) nthreads;
+        if (n == 1) {
+                apply(0, count, cl);
+                if (done != NULL) {
+                        done(0, count, cl);
+                }
+                return;
+        }
+        struct Chunk *chunks = ALLOC(n * sizeof(*chunks));
+        for (int i = 0; i < n; i++) {
+                chunks[i].lo = (int) ((long) count * i / n);
+                chunks[i].hi = (int) ((long) count * (i + 1) / n);
+                chunks[i].apply = apply;
+                chunks[i].cl = cl;
+        }
+
+        /* Start the other threads, then work on the first chunk here */
+        for (int i = 1; i < n; i++) {
+                int failed = pthread_create(&chunks[i].thread, NULL, 
+                                            run_chunk, &chunks[i]);
+                assert(!failed);
+        }
+        run_chunk(&chunks[0]);
+
+        /* Collect the chunks in order */
+        for (int i = 0; i < n; i++) {
+                if (i > 0) {
+                        pthread_join(chunks[i].thread, NULL);
+                }
+                if (done != NULL) {
+                        done(chunks[i].lo, chunks[i].hi, cl);
+                }
+        }
+        FREE(chunks);
+}
+
+/* struct Queue - The indices Parallel_each has not handed out yet */
+struct Queue {
+        int next;
+        int count;
+        Parallel_applyfun *apply;
+        void *cl;
+};
+
+static void *run_queue(void *vqueue)
+{
+        struct Queue *queue = vqueue;
+        int i;
+        while ((i = __atomic_fetch_add(&queue->next, 1, __ATOMIC_RELAXED)) <
+               queue->count) {
+                queue->apply(i, i + 1, queue->cl);
+        }
+        return NULL;
+}
+
+/***************************Parallel_each**********************************
+*
+* Calls apply on every index in [0, count), handing the indices out to 
+* nthreads threads one at a time
+*
+* Parameters: unsigned nthreads: the most threads to use, counting the caller
+*             int count: the number of indices
+*             Parallel_applyfun apply: called once per index i, as 
+*                       apply(i, i + 1, cl)
+*             void *cl: a closure passed to apply
+*
+* Expects: nthreads is not 0, count is not negative and apply is not NULL
+*
+* Return: nothing, but every index has been applied when it returns
+*
+* Notes: Indices are taken in increasing order, but may finish in any order.
+*        Never uses more threads than there are indices. Raises a checked 
+*        runtime error if a thread cannot be created.
+*********************************************************************/
+void Parallel_each(unsigned nthreads, int count, Parallel_applyfun apply, 
+                   void *cl)
+{
+        assert(nthreads > 0 && count >= 0 && apply != NULL);
+        struct Queue queue = { 0, count, apply, cl };
+        int n = (unsigned) count < nthreads ? count : (int) nthreads;
+        if (n <= 1) {
+                run_queue(&queue);
+                return;
+        }
+        pthread_t *threads = ALLOC(n * sizeof(*threads));
+        for (int i = 1; i < n; i++) {
+                int failed = pthread_create(&threads[i], NULL, run_queue, 
+                                            &queue);
+                assert(!failed);
+        }
+        run_queue(&queue);
+        for (int i = 1; i < n; i++) {
+                pthread_join(threads[i], NULL);
+        }
+        FREE(threads);
+}
+
+/***************************Parallel_processors******************************
+*
+* Returns the number of processors that are online
+*
+*********************************************************************/
+unsigned Parallel_processors(void)
+{
+        long online = sysconf(_SC_NPROCESSORS_ONLN);
+        return online > 0 ? (unsigned) online : 1;
+}
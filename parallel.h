@@ -0,0 +1,39 @@
+/*
+ *     parallel.h
+ *     by Abhinav Mummameni (amumma01) and Rolando Ortega (rorteg02)
+ *
+ *     Interface for running a loop over a range of indices on several 
+ *     threads. The range is split into one contiguous chunk per thread, and
+ *     the calling thread works on the first chunk itself. An optional 
+ *     function can be called on each chunk, in order, as soon as it and all 
+ *     of the chunks before it are finished, which lets callers emit results 
+ *     in order while later chunks are still being worked on. A second 
+ *     function hands out indices one at a time instead, like a pool of 
+ *     workers sharing a queue, for work items whose costs vary a lot.
+ */
+
+#ifndef PARALLEL_INCLUDED
+#define PARALLEL_INCLUDED
+
+/* Called on the half-open range of indices [lo, hi) */
+typedef void Parallel_applyfun(int lo, int hi, void *cl);
+
+/* Runs apply on count indices split across nthreads threads. If done is not 
+ * NULL, it is called on the calling thread for each chunk, in index order. 
+ * Checked runtime error if nthreads is 0 or count is negative. */
+extern void Parallel_for(unsigned nthreads, int count, 
+                         Parallel_applyfun apply, Parallel_applyfun done, 
+                         void *cl);
+
+/* Calls apply on each of count indices, one index at a time, on nthreads 
+ * threads (counting the caller). Each thread takes the next index as soon as
+ * it finishes the last one, so indices that take longer than others do not 
+ * hold up the rest. Checked runtime error if nthreads is 0 or count is 
+ * negative. */
+extern void Parallel_each(unsigned nthreads, int count, 
+                          Parallel_applyfun apply, void *cl);
+
+/* The number of processors online, or 1 if it cannot be determined */
+extern unsigned Parallel_processors(void);
+
+#endif
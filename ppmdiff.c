@@ -1,22 +1,54 @@
 #include "pnm.h"
-#include "a2methods.h"
-#include "a2plain.h"
+#include "ppmstream.h"
+#include "diff.h"
+#include "parallel.h"
 #include <math.h>
 #include <mem.h>
 #include <stdlib.h>
 #include <string.h>
 
-void map_error(int col, int row, A2Methods_UArray2 arr, void *elem, void *cl);
+void diff_rows(int first, int last, void *cl);
 
+/* Rows of each image held in memory at a time, per thread */
+#define WINDOW_ROWS 32
+
+/* Rows of pixels are compared as flat arrays of channels */
+typedef char Pnm_rgb_is_three_channels[
+        sizeof(struct Pnm_rgb) == 3 * sizeof(unsigned) ? 1 : -1];
+
+/* Closure for diff_rows. rows1 and rows2 hold a window of rows of each 
+ * image, width1 and width2 pixels apart. The first width pixels of row j of
+ * both are compared, and the sum of their squared differences is stored in
+ * sums[j]. */
 typedef struct Closure {
-        double *error;
-        A2Methods_UArray2 otherPixels;
-        A2Methods_T methods;
-        unsigned int denominator1;
-        unsigned int denominator2;
+        struct Pnm_rgb *rows1;
+        struct Pnm_rgb *rows2;
+        int width1;
+        int width2;
+        int width;
+        double scale1;
+        double scale2;
+        double *sums;
 } *Closure;
 
 int main(int argc, char *argv[]) {
+        /* ppmdiff [-t threads] image1 image2, where 0 threads (the default)
+         * means one per online processor */
+        unsigned threads = Parallel_processors();
+        if (argc == 5 && strcmp(argv[1], "-t") == 0) {
+                char *end;
+                long n = strtol(argv[2], &end, 10);
+                if (*end != '\0' || n < 0) {
+                        fprintf(stderr, "%s: bad thread count '%s'\n",
+                                argv[0], argv[2]);
+                        return EXIT_FAILURE;
+                }
+                if (n > 0) {
+                        threads = n;
+                }
+                argv += 2;
+                argc -= 2;
+        }
         if (argc != 3) {
                 printf("Not correct arguments\n");;
                 return EXIT_FAILURE;
@@ -39,11 +71,15 @@ int main(int argc, char *argv[]) {
                 f2 = stdin;
         }
         
-        A2Methods_T methods = uarray2_methods_plain; 
-        Pnm_ppm pic1 = Pnm_ppmread(f1, methods);
-        Pnm_ppm pic2 = Pnm_ppmread(f2, methods);
-
-        if (abs((int)pic1->width - (int)pic2->width) > 1 || abs((int)pic1->height - (int)pic2->height) > 1) {
+        /* Only the headers are read up front; the rasters are read in 
+         * lockstep, a window of rows at a time, so pipes can be compared as
+         * the data arrives and memory use depends only on the width */
+        Ppmstream_T pic1 = Ppmstream_open(f1);
+        Ppmstream_T pic2 = Ppmstream_open(f2);
+        int width1 = Ppmstream_width(pic1), height1 = Ppmstream_height(pic1);
+        int width2 = Ppmstream_width(pic2), height2 = Ppmstream_height(pic2);
+
+        if (abs(width1 - width2) > 1 || abs(height1 - height2) > 1) {
                 fprintf(stderr, "Difference in dimensions to big\n");
                 printf("1.0");
                 return EXIT_FAILURE;
@@ -52,51 +88,69 @@ int main(int argc, char *argv[]) {
         Closure cl;
         NEW(cl);
 
-        double error = 0;
-        cl->error = &error;
-        cl->otherPixels = pic2->pixels;
-        cl->methods = methods;
-        cl->denominator1 = pic1->denominator;
-        cl->denominator2 = pic2->denominator;
-
-        methods->map_default(pic1->pixels, map_error, cl);
+        /* Each thread sums its own rows of the window, and the rows are 
+         * added up in order afterwards, so the error never depends on the 
+         * threads */
+        int height = height1 < height2 ? height1 : height2;
+        int window_rows = threads == 1 ? 1 : threads * WINDOW_ROWS;
+        cl->width1 = width1;
+        cl->width2 = width2;
+        cl->width = width1 < width2 ? width1 : width2;
+        cl->scale1 = 1.0 / Ppmstream_denominator(pic1);
+        cl->scale2 = 1.0 / Ppmstream_denominator(pic2);
+        cl->rows1 = ALLOC((long) window_rows * (width1 > 0 ? width1 : 1) * 
+                          sizeof(*cl->rows1));
+        cl->rows2 = ALLOC((long) window_rows * (width2 > 0 ? width2 : 1) * 
+                          sizeof(*cl->rows2));
+        cl->sums = ALLOC(window_rows * sizeof(*cl->sums));
 
-        error /= (3.0 * fmin(pic1->width, pic2->width) * fmin(pic1->height, pic2->height));
+        double error = 0;
+        for (int done = 0; done < height; done += window_rows) {
+                int rows = height - done < window_rows ? height - done : 
+                                                         window_rows;
+                for (int row = 0; row < rows; row++) {
+                        Ppmstream_read_row(pic1, cl->rows1 + 
+                                                 (long) row * width1);
+                        Ppmstream_read_row(pic2, cl->rows2 + 
+                                                 (long) row * width2);
+                }
+                Parallel_for(threads, rows, diff_rows, NULL, cl);
+                for (int row = 0; row < rows; row++) {
+                        error += cl->sums[row];
+                }
+        }
+        error /= (3.0 * cl->width * height);
         error = sqrt(error);
 
         printf("Error: %.4f\n", error);
+        FREE(cl->sums);
+        FREE(cl->rows2);
+        FREE(cl->rows1);
         FREE(cl);
-        Pnm_ppmfree(&pic1);
-        Pnm_ppmfree(&pic2);
+        Ppmstream_close(&pic1);
+        Ppmstream_close(&pic2);
         if (f1 != stdin) {
                 fclose(f1);
         }
-        if (f1 != stdin) {
+        if (f2 != stdin) {
                 fclose(f2);
         }
 
         return EXIT_SUCCESS;
 }
 
-void map_error(int col, int row, A2Methods_UArray2 arr, void *elem, void *cl)
+/* Sums the squared differences of the rows [first, last). An apply function
+ * for Parallel_for, so it may run on its own thread. */
+void diff_rows(int first, int last, void *cl)
 {
-        (void)arr;
         Closure closure = cl;
-        double *error = closure->error;
-        A2Methods_UArray2 secondArr = closure->otherPixels;
-        A2Methods_T methods = closure->methods;
-        double denominator1 = closure->denominator1;
-        double denominator2 = closure->denominator2;
-
-        if (col >= methods->width(secondArr) || row >= methods->height(secondArr)) {
-                return;
+        for (int row = first; row < last; row++) {
+                closure->sums[row] = Diff_squares(
+                        &closure->rows1[(long) row * closure->width1].red,
+                        &closure->rows2[(long) row * closure->width2].red,
+                        3L * closure->width, closure->scale1, 
+                        closure->scale2);
         }
-
-        Pnm_rgb pixel = (Pnm_rgb)elem;
-
-        Pnm_rgb otherPixel = (Pnm_rgb)methods->at(secondArr, col, row);
-
-        *error += ((pow((double)(pixel->red / denominator1) - (double)(otherPixel->red / denominator2), 2) + 
-                pow((double)(pixel->blue / denominator1) - (double)(otherPixel->blue / denominator2), 2) + 
-                pow((double)(pixel->green / denominator1) - (double)(otherPixel->green / denominator2), 2)));
 }
+
+#undef WINDOW_ROWS
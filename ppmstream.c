@@ -0,0 +1,301 @@
+/*
+ *     ppmstream.c
+ *     by Abhinav Mummameni (amumma01) and Rolando Ortega (rorteg02)
+ *
+ *     Implementation of the Ppmstream interface
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <ctype.h>
+#include "assert.h"
+#include "except.h"
+#include "texcept.h"
+#include "mem.h"
+#include "pnm.h"
+#include "ppmstream.h"
+
+#define T Ppmstream_T
+#define MAX_DENOMINATOR 65535
+
+/* struct T - rows_read rows of the raster have been read from fp. For raw 
+ * images, bytes has room for one row of samples. */
+struct T {
+        FILE *fp;
+        int raw;
+        unsigned width, height, denominator;
+        unsigned rows_read;
+        unsigned char *bytes;
+        long row_bytes;
+};
+
+/***************************read_number**********************************
+*
+* Reads an unsigned decimal number from a PPM header or plain raster, 
+* skipping any whitespace and comments before it
+*
+*********************************************************************/
+static unsigned read_number(FILE *fp)
+{
+        int c = getc(fp);
+        while (isspace(c) || c == '#') {
+                if (c == '#') {
+                        while (c != '\n' && c != EOF) {
+                                c = getc(fp);
+                        }
+                }
+                c = getc(fp);
+        }
+        if (!isdigit(c)) {
+                TRAISE(Pnm_Badformat);
+        }
+        unsigned long n = 0;
+        while (isdigit(c)) {
+                n = 10 * n + (c - '0');
+                if (n > 0xffffffffUL) {
+                        TRAISE(Pnm_Badformat);
+                }
+                c = getc(fp);
+        }
+        ungetc(c, fp);
+        return n;
+}
+
+/***************************check_row************************************
+*
+* Raises Pnm_Badformat if any sample in a row of pixels is larger than the 
+* denominator
+*
+* Notes: The samples are or-ed together per pixel so that the loop has no 
+*        branch until the end of the row. Raw samples that fill their byte 
+*        or two can never be too large, so those rows are not checked.
+*
+*********************************************************************/
+static void check_row(T stream, const struct Pnm_rgb *row)
+{
+        unsigned width = stream->width;
+        unsigned denominator = stream->denominator;
+        if (stream->raw && (denominator == 255 || 
+                            denominator == MAX_DENOMINATOR)) {
+                return;
+        }
+        unsigned too_large = 0;
+        for (unsigned i = 0; i < width; i++) {
+                too_large |= (row[i].red > denominator) | 
+                             (row[i].green > denominator) | 
+                             (row[i].blue > denominator);
+        }
+        if (too_large) {
+                TRAISE(Pnm_Badformat);
+        }
+}
+
+/***************************Ppmstream_open**********************************
+*
+* Reads the header of a PPM image and gets ready to read its rows
+*
+* Parameters: FILE *fp: a file holding a PPM image
+*
+* Expects: fp is not NULL, checked runtime error
+*
+* Return: a new stream, which the caller must close with Ppmstream_close
+*
+* Notes: Raises Pnm_Badformat if the header is not that of a P3 or P6 image
+*        with a non-zero size and a denominator between 1 and 65535
+*
+*********************************************************************/
+T Ppmstream_open(FILE *fp)
+{
+        assert(fp != NULL);
+        int p = getc(fp);
+        int kind = getc(fp);
+        if (p != 'P' || (kind != '3' && kind != '6')) {
+                TRAISE(Pnm_Badformat);
+        }
+
+        T stream;
+        NEW(stream);
+        stream->fp = fp;
+        stream->raw = (kind == '6');
+        stream->width = read_number(fp);
+        stream->height = read_number(fp);
+        stream->denominator = read_number(fp);
+        stream->rows_read = 0;
+        stream->bytes = NULL;
+        stream->row_bytes = 0;
+        if (stream->width == 0 || stream->height == 0 || 
+            stream->denominator == 0 || 
+            stream->denominator > MAX_DENOMINATOR) {
+                FREE(stream);
+                TRAISE(Pnm_Badformat);
+        }
+
+        /* A raw raster starts after exactly one whitespace character */
+        if (stream->raw) {
+                if (!isspace(getc(fp))) {
+                        FREE(stream);
+                        TRAISE(Pnm_Badformat);
+                }
+                stream->row_bytes = Ppmstream_row_bytes(stream->width, 
+                                                        stream->denominator);
+                stream->bytes = ALLOC(stream->row_bytes);
+        }
+        return stream;
+}
+
+/***************************Ppmstream_close**********************************
+*
+* Frees a stream, leaving its file open
+*
+* Expects: stream and *stream are not NULL, checked runtime error
+*
+*********************************************************************/
+void Ppmstream_close(T *stream)
+{
+        assert(stream != NULL && *stream != NULL);
+        if ((*stream)->bytes != NULL) {
+                FREE((*stream)->bytes);
+        }
+        FREE(*stream);
+}
+
+unsigned Ppmstream_width(T stream)
+{
+        assert(stream != NULL);
+        return stream->width;
+}
+
+unsigned Ppmstream_height(T stream)
+{
+        assert(stream != NULL);
+        return stream->height;
+}
+
+unsigned Ppmstream_denominator(T stream)
+{
+        assert(stream != NULL);
+        return stream->denominator;
+}
+
+/***************************Ppmstream_read_row******************************
+*
+* Reads the next row of pixels in the image
+*
+* Parameters: T stream: the stream to read from
+*             struct Pnm_rgb *row: where to store the row of pixels
+*
+* Expects: stream and row are not NULL, row has room for a row of pixels, and
+*          not every row has been read yet; all checked runtime errors except
+*          the size of row
+*
+* Return: nothing, but row holds the next row of pixels
+*
+* Notes: A raw row is read with a single fread. Raises Pnm_Badformat if the 
+*        file ends before the row does, or if a sample of either kind of 
+*        raster is larger than the denominator.
+*
+*********************************************************************/
+void Ppmstream_read_row(T stream, struct Pnm_rgb *row)
+{
+        assert(stream != NULL && row != NULL);
+        assert(stream->rows_read < stream->height);
+        unsigned width = stream->width;
+        if (!stream->raw) {
+                for (unsigned i = 0; i < width; i++) {
+                        row[i].red = read_number(stream->fp);
+                        row[i].green = read_number(stream->fp);
+                        row[i].blue = read_number(stream->fp);
+                }
+        } else {
+                const unsigned char *b = stream->bytes;
+                if (fread(stream->bytes, 1, stream->row_bytes, stream->fp) != 
+                    (size_t) stream->row_bytes) {
+                        TRAISE(Pnm_Badformat);
+                }
+                if (stream->denominator < 256) {
+                        for (unsigned i = 0; i < width; i++, b += 3) {
+                                row[i].red = b[0];
+                                row[i].green = b[1];
+                                row[i].blue = b[2];
+                        }
+                } else {
+                        for (unsigned i = 0; i < width; i++, b += 6) {
+                                row[i].red = b[0] << 8 | b[1];
+                                row[i].green = b[2] << 8 | b[3];
+                                row[i].blue = b[4] << 8 | b[5];
+                        }
+                }
+        }
+        check_row(stream, row);
+        stream->rows_read++;
+}
+
+/***************************Ppmstream_write_header**************************
+*
+* Writes the header of a raw (P6) PPM image
+*
+* Parameters: FILE *fp: the file to write to
+*             unsigned width, height: the size of the image
+*             unsigned denominator: the denominator of the image
+*
+* Expects: fp is not NULL and denominator is between 1 and 65535, checked 
+*          runtime errors
+*
+*********************************************************************/
+void Ppmstream_write_header(FILE *fp, unsigned width, unsigned height, 
+                            unsigned denominator)
+{
+        assert(fp != NULL);
+        assert(denominator > 0 && denominator <= MAX_DENOMINATOR);
+        fprintf(fp, "P6\n%u %u\n%u\n", width, height, denominator);
+}
+
+/***************************Ppmstream_row_bytes*****************************
+*
+* Returns the number of bytes in one row of a raw PPM raster: a byte per 
+* sample for denominators below 256, and two bytes per sample otherwise
+*
+*********************************************************************/
+long Ppmstream_row_bytes(unsigned width, unsigned denominator)
+{
+        return 3L * (denominator < 256 ? 1 : 2) * width;
+}
+
+/***************************Ppmstream_pack_row******************************
+*
+* Packs a row of pixels into the bytes of a raw PPM raster
+*
+* Parameters: const struct Pnm_rgb *row: the row of pixels
+*             unsigned width: the number of pixels in the row
+*             unsigned denominator: the denominator of the image
+*             unsigned char *bytes: where to store the row
+*
+* Expects: row and bytes are not NULL, bytes has room for 
+*          Ppmstream_row_bytes bytes, and no sample is larger than 
+*          denominator
+*
+*********************************************************************/
+void Ppmstream_pack_row(const struct Pnm_rgb *row, unsigned width, 
+                        unsigned denominator, unsigned char *bytes)
+{
+        assert(row != NULL && bytes != NULL);
+        if (denominator < 256) {
+                for (unsigned i = 0; i < width; i++, bytes += 3) {
+                        bytes[0] = row[i].red;
+                        bytes[1] = row[i].green;
+                        bytes[2] = row[i].blue;
+                }
+        } else {
+                for (unsigned i = 0; i < width; i++, bytes += 6) {
+                        bytes[0] = row[i].red >> 8;
+                        bytes[1] = row[i].red;
+                        bytes[2] = row[i].green >> 8;
+                        bytes[3] = row[i].green;
+                        bytes[4] = row[i].blue >> 8;
+                        bytes[5] = row[i].blue;
+                }
+        }
+}
+
+#undef MAX_DENOMINATOR
+#undef T
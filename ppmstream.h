@@ -0,0 +1,50 @@
+/*
+ *     ppmstream.h
+ *     by Abhinav Mummameni (amumma01) and Rolando Ortega (rorteg02)
+ *
+ *     Interface for reading and writing a PPM image one row at a time. 
+ *     Ppmstream_open parses the header, and each call to Ppmstream_read_row 
+ *     converts the next row of the raster into Pnm_rgb pixels, so a whole 
+ *     image never has to be in memory at once. Both plain (P3) and raw (P6)
+ *     images are supported. Badly formatted images raise Pnm_Badformat, just
+ *     as Pnm_ppmread does. Images are written in the same raw format as 
+ *     Pnm_ppmwrite, by writing the header and then packing each row.
+ */
+
+#ifndef PPMSTREAM_INCLUDED
+#define PPMSTREAM_INCLUDED
+
+#include <stdio.h>
+#include "pnm.h"
+
+#define T Ppmstream_T
+typedef struct T *T;
+
+/* Reads the header of the PPM image in fp. Checked runtime error if fp is 
+ * NULL. Does not close fp when the stream is closed. */
+extern T    Ppmstream_open (FILE *fp);
+extern void Ppmstream_close(T *stream);
+
+extern unsigned Ppmstream_width      (T stream);
+extern unsigned Ppmstream_height     (T stream);
+extern unsigned Ppmstream_denominator(T stream);
+
+/* Reads the next row of the image into row, which must have room for 
+ * Ppmstream_width pixels. Checked runtime error if every row has already 
+ * been read; raises Pnm_Badformat if the file ends early or a sample is 
+ * larger than the denominator. */
+extern void Ppmstream_read_row(T stream, struct Pnm_rgb *row);
+
+/* Writes the header of a raw PPM image to fp */
+extern void Ppmstream_write_header(FILE *fp, unsigned width, unsigned height,
+                                   unsigned denominator);
+
+/* The number of bytes in one row of a raw PPM image */
+extern long Ppmstream_row_bytes(unsigned width, unsigned denominator);
+
+/* Packs a row of pixels into Ppmstream_row_bytes bytes of a raw raster */
+extern void Ppmstream_pack_row(const struct Pnm_rgb *row, unsigned width, 
+                               unsigned denominator, unsigned char *bytes);
+
+#undef T
+#endif
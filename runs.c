@@ -0,0 +1,240 @@
+/*
+ *     runs.c
+ *     by Abhinav Mummameni (amumma01) and Rolando Ortega (rorteg02)
+ *
+ *     Implementation of the Runs interface
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include "assert.h"
+#include "except.h"
+#include "texcept.h"
+#include "runs.h"
+
+/* The most code words one control byte can stand for, of each kind */
+#define MAX_LITERAL 128
+#define MAX_RUN 129
+
+Except_T Runs_Corrupt = { "Run-length coded row is corrupt" };
+
+/* Every block could have a control byte of its own, though Runs_encode_row
+ * only ever adds one per MAX_LITERAL blocks */
+long Runs_max_length(int count)
+{
+        assert(count >= 0);
+        return 5L * count;
+}
+
+/* Whether code words i and j at codewords are the same */
+static inline int same(const unsigned char *codewords, int i, int j)
+{
+        return memcmp(codewords + 4L * i, codewords + 4L * j, 4) == 0;
+}
+
+/***************************Runs_encode_row**********************************
+*
+* Run-length codes the code words of a block row
+*
+* Parameters: const unsigned char *codewords: the row's code words
+*             int count: the number of blocks in the row
+*             unsigned char *bytes: where to put the coded row
+*
+* Expects: codewords and bytes are not NULL, which is a checked runtime error
+*
+* Return: the length of the coded row
+*
+* Notes: Any two or more identical code words in a row become a run, since a
+*        run of two takes 5 bytes and two single code words take 8. Every
+*        other code word goes in the longest series of single code words
+*        that fits in one control byte.
+*********************************************************************/
+long Runs_encode_row(const unsigned char *codewords, int count,
+                     unsigned char *bytes)
+{
+        assert(codewords != NULL && bytes != NULL);
+        long length = 0;
+        int i = 0;
+        while (i < count) {
+                int first = i++;
+                while (i < count && i - first < MAX_RUN &&
+                       same(codewords, first, i)) {
+                        i++;
+                }
+                if (i - first >= 2) {
+                        bytes[length++] = i - first + 126;
+                        memcpy(bytes + length, codewords + 4L * first, 4);
+                        length += 4;
+                        continue;
+                }
+                while (i < count && i - first < MAX_LITERAL &&
+                       !(i + 1 < count && same(codewords, i, i + 1))) {
+                        i++;
+                }
+                bytes[length++] = i - first - 1;
+                memcpy(bytes + length, codewords + 4L * first,
+                       4L * (i - first));
+                length += 4L * (i - first);
+        }
+        return length;
+}
+
+/* The number of blocks a control byte stands for, and the number of bytes of
+ * code words that follow it */
+static inline int run_blocks(unsigned char control)
+{
+        return control < MAX_LITERAL ? control + 1 : control - 126;
+}
+
+static inline int run_bytes(unsigned char control)
+{
+        return control < MAX_LITERAL ? 4 * (control + 1) : 4;
+}
+
+/***************************Runs_row_length**********************************
+*
+* Finds the length of a coded block row
+*
+* Parameters: const unsigned char *bytes: the start of the coded row
+*             long available: the number of bytes there are at bytes
+*             int count: the number of blocks in the row
+*
+* Expects: bytes is not NULL unless available is 0, which is a checked 
+*          runtime error
+*
+* Return: the length of the row, or -1 if it goes past the available bytes
+*
+* Notes: Raises Runs_Corrupt if the runs add up to more than count blocks
+*********************************************************************/
+long Runs_row_length(const unsigned char *bytes, long available, int count)
+{
+        assert(bytes != NULL || available == 0);
+        long length = 0;
+        int blocks = 0;
+        while (blocks < count) {
+                if (length >= available) {
+                        return -1;
+                }
+                unsigned char control = bytes[length++];
+                blocks += run_blocks(control);
+                if (blocks > count) {
+                        TRAISE(Runs_Corrupt);
+                }
+                length += run_bytes(control);
+        }
+        return length <= available ? length : -1;
+}
+
+/***************************Runs_read_row**********************************
+*
+* Reads a coded block row from a file
+*
+* Parameters: FILE *fp: the file, positioned at the start of the row
+*             unsigned char *bytes: where to put the row
+*             int count: the number of blocks in the row
+*
+* Expects: fp and bytes are not NULL, which is a checked runtime error
+*
+* Return: the length of the row, or -1 if fp ends first
+*
+* Notes: Raises Runs_Corrupt if the runs add up to more than count blocks
+*********************************************************************/
+long Runs_read_row(FILE *fp, unsigned char *bytes, int count)
+{
+        assert(fp != NULL && bytes != NULL);
+        long length = 0;
+        int blocks = 0;
+        while (blocks < count) {
+                int c = getc(fp);
+                if (c == EOF) {
+                        return -1;
+                }
+                bytes[length++] = c;
+                blocks += run_blocks(c);
+                if (blocks > count) {
+                        TRAISE(Runs_Corrupt);
+                }
+                size_t want = run_bytes(c);
+                if (fread(bytes + length, 1, want, fp) != want) {
+                        return -1;
+                }
+                length += want;
+        }
+        return length;
+}
+
+int Runs_split_row(const unsigned char *bytes, int count,
+                   unsigned char *codewords, int *runs)
+{
+        assert(bytes != NULL && codewords != NULL && runs != NULL);
+        int n = 0;
+        for (int blocks = 0; blocks < count; ) {
+                unsigned char control = *bytes++;
+                if (control < MAX_LITERAL) {
+                        memcpy(codewords + 4L * n, bytes, 4 * (control + 1));
+                        for (int k = 0; k <= control; k++) {
+                                runs[n++] = 1;
+                        }
+                } else {
+                        memcpy(codewords + 4L * n, bytes, 4);
+                        runs[n++] = control - 126;
+                }
+                blocks += run_blocks(control);
+                bytes += run_bytes(control);
+        }
+        return n;
+}
+
+void Runs_gather(const unsigned char *bytes, int count, int first, int last,
+                 unsigned char *codewords)
+{
+        assert(bytes != NULL && codewords != NULL);
+        assert(first >= 0 && first <= last && last <= count);
+        for (int block = 0; block < last; ) {
+                unsigned char control = *bytes++;
+                int n = run_blocks(control);
+                for (int k = 0; k < n; k++, block++) {
+                        if (block >= first && block < last) {
+                                memcpy(codewords + 4L * (block - first),
+                                       control < MAX_LITERAL ? 
+                                       bytes + 4 * k : bytes, 4);
+                        }
+                }
+                bytes += run_bytes(control);
+        }
+}
+
+/***************************Runs_expand**********************************
+*
+* Writes every item of a row as many times as its run says
+*
+* Parameters: const unsigned char *items: n items of size bytes each
+*             const int *runs: the number of copies of each item
+*             int n, size: the number of items and their size in bytes
+*             unsigned char *out: where the copies go
+*
+* Expects: items, runs and out are not NULL, which is a checked runtime
+*          error
+*
+* Return: nothing
+*
+* Notes: The copies of a long run are made by doubling the bytes already
+*        written, so a run of r items takes about log2(r) copies.
+*********************************************************************/
+void Runs_expand(const unsigned char *items, const int *runs, int n,
+                 int size, unsigned char *out)
+{
+        assert(items != NULL && runs != NULL && out != NULL);
+        for (int k = 0; k < n; k++) {
+                const unsigned char *item = items + (long) k * size;
+                long total = (long) runs[k] * size;
+                memcpy(out, item, size);
+                for (long done = size; done < total; ) {
+                        long more = total - done < done ? total - done : done;
+                        memcpy(out + done, out, more);
+                        done += more;
+                }
+                out += total;
+        }
+}
@@ -0,0 +1,59 @@
+/*
+ *     runs.h
+ *     by Abhinav Mummameni (amumma01) and Rolando Ortega (rorteg02)
+ *
+ *     Interface for run-length coding the code words of a block row, as in
+ *     "COMP40 Compressed image format 5". Each coded row is a series of
+ *     runs, each starting with a control byte c. If c is below 128, c + 1
+ *     different code words follow, 4 bytes each. Otherwise one code word
+ *     follows, which stands for c - 126 (2 to 129) identical blocks in a
+ *     row. Runs never cross from one block row to the next, so each row can
+ *     be decoded on its own, and a row of all different code words costs
+ *     only one byte more per 128 blocks.
+ */
+
+#ifndef RUNS_INCLUDED
+#define RUNS_INCLUDED
+
+#include <stdio.h>
+#include "except.h"
+
+/* Raised when the runs of a row add up to more blocks than it has */
+extern Except_T Runs_Corrupt;
+
+/* The most bytes a coded row of count blocks can take */
+extern long Runs_max_length(int count);
+
+/* Codes the count big endian code words at codewords into bytes, which must
+ * have room for Runs_max_length(count) bytes. Returns the coded length. */
+extern long Runs_encode_row(const unsigned char *codewords, int count,
+                            unsigned char *bytes);
+
+/* Returns the length of the coded row of count blocks at the start of the
+ * available bytes at bytes, or -1 if they end before the row does */
+extern long Runs_row_length(const unsigned char *bytes, long available,
+                            int count);
+
+/* Reads a coded row of count blocks from fp into bytes, which must have room
+ * for Runs_max_length(count) bytes. Returns its length, or -1 if fp ends
+ * before the row does. */
+extern long Runs_read_row(FILE *fp, unsigned char *bytes, int count);
+
+/* Splits a coded row of count blocks, already checked by Runs_row_length or
+ * Runs_read_row, into its n runs: the code word of each goes in codewords
+ * and its number of blocks in runs, which need room for count of each.
+ * Returns n. */
+extern int  Runs_split_row(const unsigned char *bytes, int count,
+                           unsigned char *codewords, int *runs);
+
+/* Copies the code words of blocks [first, last) of a checked coded row of
+ * count blocks into codewords, 4 bytes each */
+extern void Runs_gather(const unsigned char *bytes, int count, int first,
+                        int last, unsigned char *codewords);
+
+/* Writes runs[k] copies of the k-th size byte item of items, for each of
+ * the n runs, one after another to out */
+extern void Runs_expand(const unsigned char *items, const int *runs, int n,
+                        int size, unsigned char *out);
+
+#endif
@@ -0,0 +1,136 @@
+/*
+ *     stats.c
+ *     by Abhinav Mummameni (amumma01) and Rolando Ortega (rorteg02)
+ *
+ *     Implementation of the stats interface with clock_gettime, from the
+ *     real time library. Wall time comes from CLOCK_MONOTONIC and CPU time
+ *     from CLOCK_THREAD_CPUTIME_ID, so each thread is charged only for the
+ *     CPU it used itself. Times are kept in nanoseconds and added with
+ *     atomic adds, so threads never wait on each other to record a lap.
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <time.h>
+#include <sys/resource.h>
+#include "assert.h"
+#include "stats.h"
+
+static const char *stage_names[STATS_STAGES] = {
+        "input", "convert", "quantize", "output"
+};
+
+static int enabled = 0;
+static struct Stats_mark began;
+static int64_t wall_ns[STATS_STAGES];
+static int64_t cpu_ns[STATS_STAGES];
+static long num_pixels = 0;
+static long num_blocks = 0;
+
+/* Reads a clock in nanoseconds */
+static int64_t read_clock(clockid_t clock)
+{
+        struct timespec time;
+        int result = clock_gettime(clock, &time);
+        assert(result == 0);
+        return (int64_t) time.tv_sec * 1000000000 + time.tv_nsec;
+}
+
+void Stats_enable(void)
+{
+        enabled = 1;
+        began.wall = read_clock(CLOCK_MONOTONIC);
+        began.cpu = read_clock(CLOCK_PROCESS_CPUTIME_ID);
+}
+
+int Stats_enabled(void)
+{
+        return enabled;
+}
+
+struct Stats_mark Stats_start(void)
+{
+        struct Stats_mark mark = { 0, 0 };
+        if (enabled) {
+                mark.wall = read_clock(CLOCK_MONOTONIC);
+                mark.cpu = read_clock(CLOCK_THREAD_CPUTIME_ID);
+        }
+        return mark;
+}
+
+/***************************Stats_lap**********************************
+*
+* Charges the time since a mark to a stage, and moves the mark to now
+*
+* Parameters: Stats_stage stage: the stage that just ran
+*             struct Stats_mark *mark: a mark from Stats_start or Stats_lap
+*                                      on the calling thread
+*
+* Expects: stage is a stage, not STATS_STAGES, and mark is not NULL, both of
+*          which are checked runtime errors
+*
+* Return: nothing
+*
+* Notes: With several threads, each thread's laps are added together, so the
+*        wall time of a stage can be more than the elapsed time of the run
+*********************************************************************/
+void Stats_lap(Stats_stage stage, struct Stats_mark *mark)
+{
+        assert(stage < STATS_STAGES && mark != NULL);
+        if (!enabled) {
+                return;
+        }
+        struct Stats_mark now = Stats_start();
+        __atomic_fetch_add(&wall_ns[stage], now.wall - mark->wall,
+                           __ATOMIC_RELAXED);
+        __atomic_fetch_add(&cpu_ns[stage], now.cpu - mark->cpu,
+                           __ATOMIC_RELAXED);
+        *mark = now;
+}
+
+void Stats_count(long pixels, long blocks)
+{
+        if (enabled) {
+                __atomic_fetch_add(&num_pixels, pixels, __ATOMIC_RELAXED);
+                __atomic_fetch_add(&num_blocks, blocks, __ATOMIC_RELAXED);
+        }
+}
+
+/***************************Stats_report**********************************
+*
+* Writes a table of the time spent in each stage, and the totals, to a file
+*
+* Parameters: FILE *fp: where to write the report, usually stderr
+*             const char *operation: what was timed, like "compress"
+*
+* Expects: fp and operation are not NULL, which is a checked runtime error
+*
+* Return: nothing
+*
+* Notes: The elapsed and process CPU times cover everything since
+*        Stats_enable, including time that is in no stage. A stage whose CPU
+*        time is well below its wall time was waiting, usually on I/O. Peak
+*        RSS comes from getrusage, in kilobytes.
+*********************************************************************/
+void Stats_report(FILE *fp, const char *operation)
+{
+        assert(fp != NULL && operation != NULL);
+        if (!enabled) {
+                return;
+        }
+        double elapsed = (read_clock(CLOCK_MONOTONIC) - began.wall) * 1e-9;
+        double cpu = (read_clock(CLOCK_PROCESS_CPUTIME_ID) - began.cpu) * 1e-9;
+        struct rusage usage;
+        long peak_kb = getrusage(RUSAGE_SELF, &usage) == 0 ?
+                       usage.ru_maxrss : -1;
+
+        fprintf(fp, "%s: %ld pixels, %ld blocks\n", operation, num_pixels,
+                num_blocks);
+        fprintf(fp, "  %-10s %12s %12s\n", "stage", "wall (s)", "cpu (s)");
+        for (int stage = 0; stage < STATS_STAGES; stage++) {
+                fprintf(fp, "  %-10s %12.6f %12.6f\n", stage_names[stage],
+                        wall_ns[stage] * 1e-9, cpu_ns[stage] * 1e-9);
+        }
+        fprintf(fp, "  %-10s %12.6f %12.6f\n", "total", elapsed, cpu);
+        fprintf(fp, "  peak RSS: %ld kB\n", peak_kb);
+}
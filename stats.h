@@ -0,0 +1,55 @@
+/*
+ *     stats.h
+ *     by Abhinav Mummameni (amumma01) and Rolando Ortega (rorteg02)
+ *
+ *     Interface for timing the stages of compressing or decompressing an
+ *     image, for 40image -v. Each stage adds up the wall clock and CPU time
+ *     spent in it, from any thread, and the report also holds the number of
+ *     pixels and blocks, the total elapsed and process CPU time, and the
+ *     peak resident set size. Until Stats_enable is called, every function
+ *     but Stats_report returns straight away without reading any clocks.
+ */
+
+#ifndef STATS_INCLUDED
+#define STATS_INCLUDED
+
+#include <stdio.h>
+#include <stdint.h>
+
+/* The stages of the codec, in the order they are reported */
+typedef enum {
+        STATS_INPUT,            /* parsing the input file */
+        STATS_CONVERT,          /* color conversion and the DCT, or back */
+        STATS_QUANTIZE,         /* quantizing and bitpacking, or back */
+        STATS_OUTPUT,           /* formatting and writing the output */
+        STATS_STAGES
+} Stats_stage;
+
+/* struct Stats_mark - A point in time, on the wall clock and on the CPU
+ * clock of the thread that took it */
+struct Stats_mark {
+        int64_t wall;
+        int64_t cpu;
+};
+
+/* Starts collecting statistics; the elapsed time is measured from here */
+extern void Stats_enable (void);
+extern int  Stats_enabled(void);
+
+/* Returns the current time, for a later Stats_lap on the same thread */
+extern struct Stats_mark Stats_start(void);
+
+/* Adds the time since *mark to stage, then moves *mark to now, so that
+ * consecutive stages can be timed with one mark. Safe to call from several
+ * threads at once. */
+extern void Stats_lap(Stats_stage stage, struct Stats_mark *mark);
+
+/* Adds to the number of pixels and blocks of images processed. Safe to call
+ * from several threads at once. */
+extern void Stats_count(long pixels, long blocks);
+
+/* Writes the statistics to fp, labeled with the name of the operation.
+ * Writes nothing unless Stats_enable has been called. */
+extern void Stats_report(FILE *fp, const char *operation);
+
+#endif
@@ -0,0 +1,60 @@
+/*
+ *     testutil.c
+ *     by Abhinav Mummameni (amumma01) and Rolando Ortega (rorteg02)
+ *
+ *     Implementation of the helpers shared by the test programs
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include "testutil.h"
+
+static uint64_t seed = 40;
+
+/***************************Testutil_random*********************************
+*
+* Returns the next 32 random bits
+*
+* Notes: Uses the high half of a 64-bit linear congruential generator, whose
+*        low bits are far less random
+*
+*********************************************************************/
+uint32_t Testutil_random(void)
+{
+        seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+        return seed >> 32;
+}
+
+/***************************Testutil_write_image****************************
+*
+* Writes a synthetic raw PPM image, or a truncated copy of one
+*
+* Parameters: FILE *fp: the file to write to
+*             unsigned width, height: the size of the image
+*             long keep: the number of raster bytes to write, or a negative
+*                        number for all of them
+*
+* Expects: fp is not NULL
+*
+*********************************************************************/
+void Testutil_write_image(FILE *fp, unsigned width, unsigned height, 
+                          long keep)
+{
+        fprintf(fp, "P6\n%u %u\n255\n", width, height);
+        for (unsigned j = 0; j < height; j++) {
+                for (unsigned i = 0; i < width; i++) {
+                        unsigned noise = (i * 7919 + j * 104729) % 13;
+                        unsigned char pixel[3] = {
+                                (i * 255 / width + noise) % 256,
+                                (j * 255 / height + noise) % 256,
+                                (i + j) % 200 + noise
+                        };
+                        for (int k = 0; k < 3; k++, keep--) {
+                                if (keep == 0) {
+                                        return;
+                                }
+                                putc(pixel[k], fp);
+                        }
+                }
+        }
+}
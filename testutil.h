@@ -0,0 +1,25 @@
+/*
+ *     testutil.h
+ *     by Abhinav Mummameni (amumma01) and Rolando Ortega (rorteg02)
+ *
+ *     Helpers shared by the test programs that 'make test' runs: a 
+ *     repeatable stream of random numbers and a synthetic PPM image.
+ */
+
+#ifndef TESTUTIL_INCLUDED
+#define TESTUTIL_INCLUDED
+
+#include <stdio.h>
+#include <stdint.h>
+
+/* Returns the next number from a linear congruential generator with a 
+ * fixed seed, so every run of a test sees the same numbers */
+extern uint32_t Testutil_random(void);
+
+/* Writes the header of a width by height raw PPM image with a denominator
+ * of 255 to fp, then the first keep bytes of its raster: smooth shading 
+ * with a little noise. A negative keep writes the whole raster. */
+extern void Testutil_write_image(FILE *fp, unsigned width, unsigned height,
+                                 long keep);
+
+#endif
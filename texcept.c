@@ -0,0 +1,43 @@
+/*
+ *     texcept.c
+ *     by Abhinav Mummameni (amumma01) and Rolando Ortega (rorteg02)
+ *
+ *     Implementation of the Texcept interface
+ */
+
+#include <stdlib.h>
+#include <setjmp.h>
+#include "except.h"
+#include "texcept.h"
+
+__thread Texcept_Frame *Texcept_stack = NULL;
+
+/***************************Texcept_raise**********************************
+*
+* Raises an exception in the innermost TTRY block of the calling thread
+*
+* Parameters: const Except_T *e: the exception to raise
+*             const char *file, int line: where it was raised
+*
+* Expects: e is not NULL
+*
+* Return: never
+*
+* Notes: The frame is popped before jumping to it, so TRERAISE in a handler
+*        goes on to the next block out. With no TTRY block on the thread, 
+*        the exception goes to the CII's Except_raise, which hands it to any
+*        TRY block or else reports it and aborts.
+*********************************************************************/
+void Texcept_raise(const Except_T *e, const char *file, int line)
+{
+        Texcept_Frame *frame = Texcept_stack;
+        if (frame == NULL) {
+                Except_raise(e, file, line);
+                abort();
+        }
+        frame->exception = e;
+        frame->file = file;
+        frame->line = line;
+        Texcept_stack = frame->prev;
+        longjmp(frame->env, Texcept_raised);
+}
@@ -0,0 +1,79 @@
+/*
+ *     texcept.h
+ *     by Abhinav Mummameni (amumma01) and Rolando Ortega (rorteg02)
+ *
+ *     Interface for exceptions that are handled on the thread that raises
+ *     them. It mirrors the CII's except.h, with a T in front of each macro,
+ *     but each thread keeps its own stack of handlers, so several threads 
+ *     can be in TTRY blocks at once. The exceptions themselves are ordinary
+ *     Except_Ts. An exception raised with TRAISE where the thread has no 
+ *     TTRY block goes on to the CII's Except_raise, so, just like RAISE, it
+ *     is reported as uncaught and aborts the program.
+ *
+ *     A function that holds resources while something it calls may raise 
+ *     an exception frees them in a TELSE or TFINALLY clause. As with TRY, 
+ *     locals changed inside a TTRY block and used after an exception must 
+ *     be volatile, and a TTRY block may not be left with return or goto.
+ */
+
+#ifndef TEXCEPT_INCLUDED
+#define TEXCEPT_INCLUDED
+
+#include <setjmp.h>
+#include "except.h"
+
+typedef struct Texcept_Frame Texcept_Frame;
+struct Texcept_Frame {
+        Texcept_Frame *prev;
+        jmp_buf env;
+        const char *file;
+        int line;
+        const Except_T *exception;
+};
+
+enum { Texcept_entered = 0, Texcept_raised, Texcept_handled, 
+       Texcept_finalized };
+
+/* The innermost TTRY block of the calling thread */
+extern __thread Texcept_Frame *Texcept_stack;
+
+/* Raises e in the innermost TTRY block of the calling thread, or, if there
+ * is none, with Except_raise */
+extern void Texcept_raise(const Except_T *e, const char *file, int line);
+
+#define TRAISE(e) Texcept_raise(&(e), __FILE__, __LINE__)
+#define TRERAISE Texcept_raise(Texcept_frame.exception, Texcept_frame.file, \
+                               Texcept_frame.line)
+
+#define TTRY do { \
+        volatile int Texcept_flag; \
+        Texcept_Frame Texcept_frame; \
+        Texcept_frame.prev = Texcept_stack; \
+        Texcept_stack = &Texcept_frame; \
+        Texcept_flag = setjmp(Texcept_frame.env); \
+        if (Texcept_flag == Texcept_entered) {
+#define TEXCEPT(e) \
+                if (Texcept_flag == Texcept_entered) \
+                        Texcept_stack = Texcept_stack->prev; \
+        } else if (Texcept_frame.exception == &(e)) { \
+                Texcept_flag = Texcept_handled;
+#define TELSE \
+                if (Texcept_flag == Texcept_entered) \
+                        Texcept_stack = Texcept_stack->prev; \
+        } else { \
+                Texcept_flag = Texcept_handled;
+#define TFINALLY \
+                if (Texcept_flag == Texcept_entered) \
+                        Texcept_stack = Texcept_stack->prev; \
+        } { \
+                if (Texcept_flag == Texcept_entered) \
+                        Texcept_flag = Texcept_finalized;
+#define TEND_TRY \
+                if (Texcept_flag == Texcept_entered) \
+                        Texcept_stack = Texcept_stack->prev; \
+        } \
+        if (Texcept_flag == Texcept_raised) \
+                TRERAISE; \
+} while (0)
+
+#endif
@@ -0,0 +1,355 @@
+/*
+ *     tiles.c
+ *     by Abhinav Mummameni (amumma01) and Rolando Ortega (rorteg02)
+ *
+ *     Implementation of the Tiles interface. Every plain tile holds 4 bytes
+ *     per block, so the offsets of a new plain image are known before any 
+ *     code word is written, and the index can go in the header even when 
+ *     the output is a pipe; writing only ever holds one row of tiles in 
+ *     memory. Coded tiles are held until the end, which costs memory for 
+ *     the coded bytes of the whole image, but only for those.
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include "assert.h"
+#include "except.h"
+#include "texcept.h"
+#include "mem.h"
+#include "entropy.h"
+#include "tiles.h"
+
+#define T Tiles_T
+
+Except_T Tiles_Badindex = { "Tile index is corrupt" };
+
+/* struct T - The image has count blocks in each of its rows block rows, and
+ * each tile is side blocks on a side; there are across tiles in a row of
+ * tiles and down rows of tiles. offsets has across * down + 1 entries.
+ * buffer holds the held block rows of the current row of tiles, and written
+ * block rows have been given to Tiles_write_row so far. If coded is 
+ * nonzero, the coded tiles so far are kept in the first length of the 
+ * capacity bytes of tiles, and when reading, the tiles of row cached_row 
+ * that are marked in decoded are in cache, plain. */
+struct T {
+        int count;
+        int rows;
+        int side;
+        int across;
+        int down;
+        uint64_t *offsets;
+        unsigned char *buffer;
+        int held;
+        int written;
+        int coded;
+        unsigned char *tiles;
+        long length;
+        long capacity;
+        unsigned char *cache;
+        char *decoded;
+        int cached_row;
+};
+
+/* The number of blocks across tile column tile, and down tile row tile */
+static inline int tile_width(T tiles, int tile)
+{
+        int rest = tiles->count - tile * tiles->side;
+        return rest < tiles->side ? rest : tiles->side;
+}
+
+static inline int tile_height(T tiles, int tile)
+{
+        int rest = tiles->rows - tile * tiles->side;
+        return rest < tiles->side ? rest : tiles->side;
+}
+
+/***************************Tiles_new**********************************
+*
+* Creates the layout of the tiles of an image
+*
+* Parameters: unsigned width, height: the size of the image in pixels
+*             unsigned tile_size: the size of each tile in pixels
+*             int coded: nonzero for entropy coded tiles
+*
+* Expects: tile_size is even and at least 2, which is a checked runtime error
+*
+* Return: the new layout. With plain tiles, the offsets are already known.
+*
+* Notes: a last odd row or column of pixels is not part of any block
+*********************************************************************/
+T Tiles_new(unsigned width, unsigned height, unsigned tile_size, int coded)
+{
+        assert(tile_size >= 2 && tile_size % 2 == 0);
+        T tiles;
+        NEW(tiles);
+        tiles->count = width / 2;
+        tiles->rows = height / 2;
+        tiles->side = tile_size / 2;
+        tiles->across = (tiles->count + tiles->side - 1) / tiles->side;
+        tiles->down = (tiles->rows + tiles->side - 1) / tiles->side;
+        tiles->buffer = NULL;
+        tiles->held = 0;
+        tiles->written = 0;
+        tiles->coded = coded;
+        tiles->tiles = NULL;
+        tiles->length = tiles->capacity = 0;
+        tiles->cache = NULL;
+        tiles->decoded = NULL;
+        tiles->cached_row = -1;
+
+        long n = Tiles_count(tiles);
+        tiles->offsets = ALLOC((n + 1) * sizeof(*tiles->offsets));
+        tiles->offsets[0] = 0;
+        for (long i = 0; i < n; i++) {
+                tiles->offsets[i + 1] = tiles->offsets[i] + 4 * (uint64_t)
+                        tile_width(tiles, i % tiles->across) *
+                        tile_height(tiles, i / tiles->across);
+        }
+        return tiles;
+}
+
+void Tiles_free(T *tiles)
+{
+        assert(tiles != NULL && *tiles != NULL);
+        FREE((*tiles)->offsets);
+        FREE((*tiles)->buffer);
+        FREE((*tiles)->tiles);
+        FREE((*tiles)->cache);
+        FREE((*tiles)->decoded);
+        FREE(*tiles);
+}
+
+long Tiles_count(T tiles)
+{
+        assert(tiles != NULL);
+        return (long) tiles->across * tiles->down;
+}
+
+long Tiles_payload_length(T tiles)
+{
+        assert(tiles != NULL);
+        return tiles->offsets[Tiles_count(tiles)];
+}
+
+static void write_index(T tiles, Outbuf_T out)
+{
+        unsigned char bytes[8];
+        for (long i = 0; i <= Tiles_count(tiles); i++) {
+                for (int k = 0; k < 8; k++) {
+                        bytes[k] = tiles->offsets[i] >> (56 - 8 * k);
+                }
+                Outbuf_put_bytes(out, bytes, 8);
+        }
+}
+
+void Tiles_begin(T tiles, Outbuf_T out)
+{
+        assert(tiles != NULL && out != NULL);
+        if (!tiles->coded) {
+                write_index(tiles, out);
+        }
+}
+
+void Tiles_end(T tiles, Outbuf_T out)
+{
+        assert(tiles != NULL && out != NULL);
+        assert(tiles->written == tiles->rows);
+        if (tiles->coded) {
+                write_index(tiles, out);
+                Outbuf_put_bytes(out, tiles->tiles, tiles->length);
+        }
+}
+
+/***************************Tiles_read_index*******************************
+*
+* Reads the index of the tiles of an image
+*
+* Parameters: T tiles: the layout of the image's tiles
+*             FILE *fp: the file, positioned just after its header
+*
+* Expects: tiles and fp are not NULL, which is a checked runtime error
+*
+* Return: nothing, but leaves fp positioned at the first tile
+*
+* Notes: Raises Tiles_Badindex if the index is cut short, or if any offset
+*        of a plain image differs from the one Tiles_new found, since every 
+*        tile must hold exactly 4 bytes per block. The offsets of a coded 
+*        image must start at 0 and go up with every tile.
+*********************************************************************/
+void Tiles_read_index(T tiles, FILE *fp)
+{
+        assert(tiles != NULL && fp != NULL);
+        unsigned char bytes[8];
+        for (long i = 0; i <= Tiles_count(tiles); i++) {
+                if (fread(bytes, 1, 8, fp) != 8) {
+                        TRAISE(Tiles_Badindex);
+                }
+                uint64_t offset = 0;
+                for (int k = 0; k < 8; k++) {
+                        offset = offset << 8 | bytes[k];
+                }
+                if (tiles->coded) {
+                        if (i == 0 ? offset != 0 : 
+                                     offset <= tiles->offsets[i - 1]) {
+                                TRAISE(Tiles_Badindex);
+                        }
+                        tiles->offsets[i] = offset;
+                } else if (offset != tiles->offsets[i]) {
+                        TRAISE(Tiles_Badindex);
+                }
+        }
+}
+
+/* Entropy codes each tile of the row of tiles in the buffer, and appends it
+ * to the coded tiles */
+static void code_tiles(T tiles, int tile_row)
+{
+        long row_bytes = 4L * tiles->count;
+        unsigned char *plain = ALLOC(4L * tiles->side * tiles->side);
+        for (int tile = 0; tile < tiles->across; tile++) {
+                int width = tile_width(tiles, tile);
+                for (int row = 0; row < tiles->held; row++) {
+                        memcpy(plain + 4L * row * width, tiles->buffer + 
+                               row * row_bytes + 4L * tile * tiles->side,
+                               4L * width);
+                }
+                long length;
+                unsigned char *coded = Entropy_encode(plain, width, 
+                                                      tiles->held, &length);
+                if (tiles->length + length > tiles->capacity) {
+                        tiles->capacity = 2 * (tiles->length + length);
+                        if (tiles->tiles == NULL) {
+                                tiles->tiles = ALLOC(tiles->capacity);
+                        } else {
+                                RESIZE(tiles->tiles, tiles->capacity);
+                        }
+                }
+                memcpy(tiles->tiles + tiles->length, coded, length);
+                tiles->length += length;
+                long i = (long) tile_row * tiles->across + tile;
+                tiles->offsets[i + 1] = tiles->offsets[i] + length;
+                FREE(coded);
+        }
+        FREE(plain);
+}
+
+/***************************Tiles_write_row*******************************
+*
+* Collects the code words of one block row, and writes a whole row of tiles
+* once it has all of the block rows that the tiles cover
+*
+* Parameters: T tiles: the layout of the image's tiles
+*             const unsigned char *codewords: the 4 * count bytes of the
+*                                             next block row
+*             Outbuf_T out: where plain tiles go, just after the index
+*
+* Expects: no more block rows than the image has, which is a checked runtime
+*          error
+*
+* Return: nothing
+*
+*********************************************************************/
+void Tiles_write_row(T tiles, const unsigned char *codewords, Outbuf_T out)
+{
+        assert(tiles != NULL && codewords != NULL && out != NULL);
+        assert(tiles->written < tiles->rows);
+        long row_bytes = 4L * tiles->count;
+        if (tiles->buffer == NULL) {
+                tiles->buffer = ALLOC(tiles->side * row_bytes);
+        }
+        memcpy(tiles->buffer + tiles->held * row_bytes, codewords, row_bytes);
+        tiles->held++;
+        tiles->written++;
+
+        int tile_row = (tiles->written - 1) / tiles->side;
+        if (tiles->held < tile_height(tiles, tile_row)) {
+                return;
+        }
+        if (tiles->coded) {
+                code_tiles(tiles, tile_row);
+                tiles->held = 0;
+                return;
+        }
+        for (int tile = 0; tile < tiles->across; tile++) {
+                long first = 4L * tile * tiles->side;
+                long bytes = 4L * tile_width(tiles, tile);
+                for (int row = 0; row < tiles->held; row++) {
+                        Outbuf_put_bytes(out, tiles->buffer +
+                                              row * row_bytes + first, bytes);
+                }
+        }
+        tiles->held = 0;
+}
+
+/* Returns the plain code words of a coded tile, decoding it into the cache
+ * first if it is not there yet. The cache holds a row of tiles laid out 
+ * just as plain tiles are. */
+static const unsigned char *cached_tile(T tiles, const unsigned char *payload,
+                                        int tile_row, int tile)
+{
+        int height = tile_height(tiles, tile_row);
+        if (tiles->cache == NULL) {
+                tiles->cache = ALLOC(4L * tiles->side * tiles->count);
+                tiles->decoded = ALLOC(tiles->across);
+        }
+        if (tiles->cached_row != tile_row) {
+                memset(tiles->decoded, 0, tiles->across);
+                tiles->cached_row = tile_row;
+        }
+        unsigned char *plain = tiles->cache + 
+                               4L * height * tile * tiles->side;
+        if (!tiles->decoded[tile]) {
+                long i = (long) tile_row * tiles->across + tile;
+                Entropy_decode(payload + tiles->offsets[i], 
+                               tiles->offsets[i + 1] - tiles->offsets[i], 
+                               tile_width(tiles, tile), height, plain);
+                tiles->decoded[tile] = 1;
+        }
+        return plain;
+}
+
+/***************************Tiles_gather**********************************
+*
+* Copies the code words of a run of blocks in one block row out of the tiles
+*
+* Parameters: T tiles: the layout of the image's tiles
+*             const unsigned char *payload: the tiles, as written
+*             int row: the block row
+*             int first, last: the blocks [first, last) of the row to copy
+*             unsigned char *bytes: where to put 4 * (last - first) bytes
+*
+* Expects: row is a block row of the image and first <= last <= count, which
+*          are checked runtime errors
+*
+* Return: nothing
+*
+*********************************************************************/
+void Tiles_gather(T tiles, const unsigned char *payload, int row, int first,
+                  int last, unsigned char *bytes)
+{
+        assert(tiles != NULL && payload != NULL && bytes != NULL);
+        assert(row >= 0 && row < tiles->rows);
+        assert(first >= 0 && first <= last && last <= tiles->count);
+        int tile_row = row / tiles->side;
+        int row_in_tile = row % tiles->side;
+        while (first < last) {
+                int tile = first / tiles->side;
+                int width = tile_width(tiles, tile);
+                int end = tile * tiles->side + width;
+                end = end < last ? end : last;
+                const unsigned char *base = tiles->coded ? 
+                        cached_tile(tiles, payload, tile_row, tile) : 
+                        payload + tiles->offsets[(long) tile_row * 
+                                                 tiles->across + tile];
+                const unsigned char *start = base + 
+                        4L * ((long) row_in_tile * width +
+                              first - tile * tiles->side);
+                memcpy(bytes, start, 4L * (end - first));
+                bytes += 4L * (end - first);
+                first = end;
+        }
+}
+
+#undef T
@@ -0,0 +1,71 @@
+/*
+ *     tiles.h
+ *     by Abhinav Mummameni (amumma01) and Rolando Ortega (rorteg02)
+ *
+ *     Interface for the tiles of a "COMP40 Compressed image format 3" file.
+ *     The blocks of the image are grouped into square tiles of a fixed
+ *     number of blocks on a side (the tiles on the right and bottom edges
+ *     may be smaller). The tiles are stored one after another, in row-major
+ *     order, each holding the code words of its blocks in row-major order.
+ *     The header of the file is followed by an index of the byte offset of
+ *     every tile from the start of the tiles, plus one more offset for the
+ *     end of the last tile, each 8 bytes in big endian order. With the
+ *     index, any block can be found without reading the tiles before it, so
+ *     a rectangle of a huge image can be decoded on its own.
+ *
+ *     In a plain tiled image ("format 3") each tile holds 4 bytes per 
+ *     block. In an entropy coded one ("format 4") each tile is coded on its
+ *     own with the entropy interface, so tiles differ in size, but can 
+ *     still be decoded without any of the others.
+ */
+
+#ifndef TILES_INCLUDED
+#define TILES_INCLUDED
+
+#include <stdio.h>
+#include "except.h"
+#include "outbuf.h"
+
+#define T Tiles_T
+typedef struct T *T;
+
+/* Raised when a tile index is cut short or does not match its image */
+extern Except_T Tiles_Badindex;
+
+/* Creates the layout of the tiles of a width by height image, with tiles of
+ * tile_size pixels on a side, entropy coded if coded is nonzero. Checked 
+ * runtime error if tile_size is odd or below 2. */
+extern T    Tiles_new (unsigned width, unsigned height, unsigned tile_size,
+                       int coded);
+extern void Tiles_free(T *tiles);
+
+/* The number of tiles, and the number of bytes they take up in all */
+extern long Tiles_count         (T tiles);
+extern long Tiles_payload_length(T tiles);
+
+/* Writing a tiled image: Tiles_begin is called just after the header, 
+ * then Tiles_write_row with the code words of each block row in turn, in
+ * row-major order, then Tiles_end. Plain tiles are written (after the 
+ * index) as soon as a whole row of tiles has been given. Coded tiles are 
+ * kept in memory, since their offsets are only known once they are all 
+ * coded, and are written after the index by Tiles_end. */
+extern void Tiles_begin    (T tiles, Outbuf_T out);
+extern void Tiles_write_row(T tiles, const unsigned char *codewords,
+                            Outbuf_T out);
+extern void Tiles_end      (T tiles, Outbuf_T out);
+
+/* Reads the index of the tiles from fp, which must be positioned just after
+ * the header. Raises Tiles_Badindex if the index is short or its offsets do
+ * not fit the tiles. */
+extern void Tiles_read_index(T tiles, FILE *fp);
+
+/* Copies the code words of blocks [first, last) of block row row out of the
+ * tiles in payload and into bytes, in row-major order. Coded tiles are 
+ * decoded the first time they are needed, and the decoded tiles of one row
+ * of tiles are kept until a block row from another row of tiles is asked 
+ * for. Raises Entropy_Corrupt if a coded tile cannot be decoded. */
+extern void Tiles_gather(T tiles, const unsigned char *payload, int row,
+                         int first, int last, unsigned char *bytes);
+
+#undef T
+#endif